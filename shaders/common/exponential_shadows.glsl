@@ -0,0 +1,11 @@
+//exponential shadow maps, shared by the blur that builds them & the lit shaders that read them
+//included by shaders through Shader::Library, and not compiled by itself
+
+const float ESM_EXPONENT = 80.0; //sharpness of the occluders' falloff, exp(80) still fits in a 32-bit float
+const int ESM_DOWNSAMPLE = 2; //exponential maps are this many times smaller than the shadow maps (has to match Renderer::ESM_DOWNSAMPLE)
+const int ESM_BLUR_RADIUS = 4; //in exponential map texels, on each side
+
+//depth in [0, 1] from the near to the far plane, since a perspective one is too compressed for the exponent to tell depths apart
+float LinearShadowDepth(float depth, float depthRatio) {
+    return depthRatio * depth / (1.0 - (1.0 - depthRatio) * depth);
+}
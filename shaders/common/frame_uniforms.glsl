@@ -0,0 +1,25 @@
+//per-pass uniforms, shared by every program (see FrameUniforms.h)
+//included by shaders through Shader::Library, and not compiled by itself
+
+layout (std140) uniform FrameUniforms {
+    mat4 u_view_projection; //view projection matrix
+
+    vec3 u_cam_pos; //cam position
+    float u_ambient_strength; //ambient light strength
+
+    vec3 u_light_pos; //main light position
+    float u_specular_strength; //specular light strength
+
+    vec3 u_light_color; //main light color
+    float u_shadows_influence; //are shadows enabled?
+
+    mat4 u_shadow_view_projections[6]; //view projection matrix of each shadow map (a single one, one per sun cascade, or one per cube face)
+    vec4 u_shadow_depth_params[6]; //depth bias of each shadow map in its own depth range, then its near over far plane ratio (1 for orthographic ones)
+    int u_shadow_map_count; //number of used shadow maps, each of them having a static & a dynamic layer
+
+    int u_cluster_count_x; //point lights' cluster grid size
+    int u_cluster_count_y;
+    int u_cluster_count_z;
+    vec4 u_cluster_depth_params; //camera near & far planes, then the scale & bias that turn a log view depth into a cluster slice
+    vec2 u_cluster_tile_size; //in pixels
+};
\ No newline at end of file
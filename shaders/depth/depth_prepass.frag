@@ -0,0 +1,8 @@
+//depth prepass fragment shader
+
+#version 330 core
+
+//entrypoint
+void main() {
+    //nothing to output, only depth is written (and not touching gl_FragDepth keeps early depth testing on)
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+//depth prepass vertex shader
+
+#version 330 core
+
+#include "../common/frame_uniforms.glsl"
+
+uniform mat4 u_model_transform; //model matrix
+
+layout (location = 0) in vec3 vPos; //vertex input position (the only attribute of the position-only stream)
+
+invariant gl_Position; //the color pass' depth has to match this one exactly (see lit.vert & unlit.vert)
+
+void main() {
+    gl_Position = u_view_projection * u_model_transform * vec4(vPos, 1.0); //gl_Position is a built-in property of a vertex shader
+}
\ No newline at end of file
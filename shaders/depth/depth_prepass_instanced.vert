@@ -0,0 +1,14 @@
+//instanced depth prepass vertex shader, identical to the default one except for where the model matrix comes from
+
+#version 330 core
+
+#include "../common/frame_uniforms.glsl"
+
+layout (location = 0) in vec3 vPos; //vertex input position
+layout (location = 3) in mat4 vInstanceTransform; //per-instance model matrix (takes locations 3 to 6)
+
+invariant gl_Position; //the color pass' depth has to match this one exactly (see lit_instanced.vert)
+
+void main() {
+    gl_Position = u_view_projection * vInstanceTransform * vec4(vPos, 1.0); //gl_Position is a built-in property of a vertex shader
+}
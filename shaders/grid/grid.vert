@@ -2,8 +2,9 @@
 
 #version 330 core
 
+#include "../common/frame_uniforms.glsl"
+
 uniform mat4 u_model_transform; //model matrix
-uniform mat4 u_view_projection; //view projection matrix
 
 layout (location = 0) in vec3 vPos; //vertex input position
 
@@ -2,31 +2,166 @@
 
 #version 330 core
 
-uniform vec3 u_cam_pos; //cam position
+#include "../common/frame_uniforms.glsl"
+#include "../common/exponential_shadows.glsl"
 
-uniform vec3 u_light_pos; //main light position
-uniform vec3 u_light_color; //main light color
+//number of shadow map taps, each of them already 2x2 filtered by the hardware (1, 4, 9 or 16, the last one on a Poisson disk)
+#ifndef SHADOW_TAPS
+#define SHADOW_TAPS 1
+#endif
+
+//whether shadows are looked up in the blurred exponential shadow maps, instead of comparing depths in the shadow maps themselves
+#ifndef SHADOW_ESM
+#define SHADOW_ESM 0
+#endif
 
-uniform float u_ambient_strength; //ambient light strength
-uniform float u_specular_strength; //specular light strength
 uniform int u_shininess; //light shininess
 
-uniform vec3 u_color; //cube color
 uniform float u_alpha; //cube opacity
 
-uniform float u_shadows_influence = 1.0; //are shadows enabled?
 uniform float u_texture_influence = 0.5; //are textures enabled?
 
-uniform sampler2D u_depth_texture; //light screen depth texture
+uniform bool u_receives_shadows = true; //materials that don't receive shadows are always lit
+
+uniform sampler2DArrayShadow u_depth_texture; //light screen depth textures, compared by the hardware (the static casters' layer of each shadow map, then their dynamic casters' layer)
 uniform sampler2D u_texture; //object texture
+uniform sampler2DArray u_exponential_shadows; //blurred exp(ESM_EXPONENT * occluder depth) of each shadow map, both layers combined
+
+uniform samplerBuffer u_point_lights; //3 texels per point light: position & radius, color & intensity, then its first shadow atlas tile (-1 if unshadowed)
+uniform usamplerBuffer u_light_grid; //offset & count of each cluster's lights in u_light_indices
+uniform usamplerBuffer u_light_indices; //point lights of every cluster, one after the other
+
+uniform sampler2DShadow u_shadow_atlas; //depth of every shadowed point light's cube faces, one tile each, compared by the hardware
+uniform samplerBuffer u_shadow_tiles; //5 texels per tile: its view projection, then its offset & size in atlas uvs & its depth bias
 
 in vec3 FragPos;
 in vec3 Normal;
-in vec4 FragPosLightSpace;
 in vec2 FragUv;
+in vec3 Color; //object color (per-instance, when instanced)
 
 layout(location = 0) out vec4 out_color; //rgba color output
 
+const float POISSON_RADIUS = 1.5; //in texels, also the widest reach of the other kernels
+
+#if SHADOW_ESM
+const float SHADOW_REACH = float((ESM_BLUR_RADIUS + 1) * ESM_DOWNSAMPLE); //in shadow map texels
+#else
+const float SHADOW_REACH = POISSON_RADIUS;
+#endif
+
+#if SHADOW_TAPS == 16
+
+const vec2 POISSON_DISK[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725), vec2(-0.09418410, -0.92938870), vec2(0.34495938, 0.29387760),
+    vec2(-0.91588581, 0.45771432), vec2(-0.81544232, -0.87912464), vec2(-0.38277543, 0.27676845), vec2(0.97484398, 0.75648379),
+    vec2(0.44323325, -0.97511554), vec2(0.53742981, -0.47373420), vec2(-0.26496911, -0.41893023), vec2(0.79197514, 0.19090188),
+    vec2(-0.24188840, 0.99706507), vec2(-0.81409955, 0.91437590), vec2(0.19984126, 0.78641367), vec2(0.14383161, -0.14100790)
+);
+#endif
+
+//fraction of the shadow map's taps around the coordinates that are lit
+float SampleShadow(vec3 projectedCoords, int shadowMap, float bias) {
+    vec2 texelSize = 1.0 / vec2(textureSize(u_depth_texture, 0).xy);
+    float referenceDepth = projectedCoords.z - bias;
+
+#if SHADOW_TAPS == 16
+    float lit = 0.0;
+
+    for (int i = 0; i < 16; ++i)
+        lit += texture(u_depth_texture, vec4(projectedCoords.xy + POISSON_DISK[i] * POISSON_RADIUS * texelSize, shadowMap, referenceDepth));
+
+    return lit / 16.0;
+#elif SHADOW_TAPS == 9
+    float lit = 0.0;
+
+    for (int x = -1; x <= 1; ++x)
+        for (int y = -1; y <= 1; ++y)
+            lit += texture(u_depth_texture, vec4(projectedCoords.xy + vec2(x, y) * texelSize, shadowMap, referenceDepth));
+
+    return lit / 9.0;
+#elif SHADOW_TAPS == 4
+    float lit = 0.0;
+
+    for (float x = -0.5; x <= 0.5; x += 1.0)
+        for (float y = -0.5; y <= 0.5; y += 1.0)
+            lit += texture(u_depth_texture, vec4(projectedCoords.xy + vec2(x, y) * texelSize, shadowMap, referenceDepth));
+
+    return lit / 4.0;
+#else
+    return texture(u_depth_texture, vec4(projectedCoords.xy, shadowMap, referenceDepth));
+#endif
+}
+
+//fraction of the light that reaches the coordinates past the blurred occluders, exp(ESM_EXPONENT * (occluder depth - receiver depth))
+float SampleExponentialShadow(vec3 projectedCoords, int shadowMap, float bias) {
+    float occluders = texture(u_exponential_shadows, vec3(projectedCoords.xy, shadowMap)).r;
+    float receiverDepth = LinearShadowDepth(projectedCoords.z - bias, u_shadow_depth_params[shadowMap].y);
+
+    return clamp(occluders * exp(-ESM_EXPONENT * receiverDepth), 0.0, 1.0);
+}
+
+//fraction of a point light that reaches the fragment, from the atlas tile of the cube face the fragment is in
+float PointLightShadow(vec3 lightPosition, int firstTile) {
+    vec3 fromLight = FragPos - lightPosition;
+    vec3 axisDistances = abs(fromLight);
+
+    //+X, -X, +Y, -Y, +Z & -Z, the faces being exactly 90 degrees wide so that the major axis picks the only one that covers the fragment
+    int face = axisDistances.x >= axisDistances.y && axisDistances.x >= axisDistances.z ? (fromLight.x > 0.0 ? 0 : 1)
+             : axisDistances.y >= axisDistances.z ? (fromLight.y > 0.0 ? 2 : 3)
+             : (fromLight.z > 0.0 ? 4 : 5);
+
+    int tile = (firstTile + face) * 5;
+    mat4 tileViewProjection = mat4(texelFetch(u_shadow_tiles, tile), texelFetch(u_shadow_tiles, tile + 1), texelFetch(u_shadow_tiles, tile + 2), texelFetch(u_shadow_tiles, tile + 3));
+    vec4 tileRect = texelFetch(u_shadow_tiles, tile + 4);
+
+    vec4 fragPosLightSpace = tileViewProjection * vec4(FragPos, 1.0);
+    vec3 tileCoords = fragPosLightSpace.xyz / fragPosLightSpace.w * 0.5 + 0.5;
+
+    //kept half a texel inside the tile, so that the hardware's 2x2 filtering never reaches into its neighbours
+    float halfTexel = 0.5 / (tileRect.z * float(textureSize(u_shadow_atlas, 0).x));
+    vec2 atlasCoords = tileRect.xy + clamp(tileCoords.xy, halfTexel, 1.0 - halfTexel) * tileRect.z;
+
+    return texture(u_shadow_atlas, vec3(atlasCoords, tileCoords.z - tileRect.w));
+}
+
+//diffuse & specular light of every point light of the fragment's cluster
+vec3 PointLighting(vec3 norm, vec3 viewDir) {
+    //the fragment's view depth, back from its non-linear depth buffer value
+    float near = u_cluster_depth_params.x;
+    float far = u_cluster_depth_params.y;
+    float viewDepth = 2.0 * near * far / (far + near - (gl_FragCoord.z * 2.0 - 1.0) * (far - near));
+
+    ivec3 cluster = ivec3(gl_FragCoord.xy / u_cluster_tile_size, log(viewDepth) * u_cluster_depth_params.z + u_cluster_depth_params.w);
+    cluster = clamp(cluster, ivec3(0), ivec3(u_cluster_count_x, u_cluster_count_y, u_cluster_count_z) - 1);
+
+    uvec2 lightRange = texelFetch(u_light_grid, cluster.x + u_cluster_count_x * (cluster.y + u_cluster_count_y * cluster.z)).xy;
+    vec3 lighting = vec3(0.0);
+
+    for (uint i = 0u; i < lightRange.y; ++i) {
+        int light = int(texelFetch(u_light_indices, int(lightRange.x + i)).x);
+        vec4 positionRadius = texelFetch(u_point_lights, light * 3);
+        vec4 colorIntensity = texelFetch(u_point_lights, light * 3 + 1);
+        int shadowTile = int(texelFetch(u_point_lights, light * 3 + 2).x);
+
+        vec3 toLight = positionRadius.xyz - FragPos;
+        float lightDistance = length(toLight);
+        vec3 lightDir = toLight / lightDistance;
+
+        //inverse square falloff, smoothly brought down to 0 at the light's radius, past which it isn't binned
+        float window = clamp(1.0 - pow(lightDistance / positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (1.0 + lightDistance * lightDistance);
+
+        float diffFactor = max(dot(lightDir, norm), 0.0);
+        float specularFactor = pow(max(dot(viewDir, reflect(-lightDir, norm)), 0.0), u_shininess) * u_specular_strength;
+
+        float lit = shadowTile >= 0 && u_receives_shadows ? PointLightShadow(positionRadius.xyz, shadowTile) : 1.0;
+
+        lighting += (diffFactor + specularFactor) * colorIntensity.rgb * colorIntensity.a * attenuation * lit;
+    }
+
+    return lighting;
+}
+
 //entrypoint
 void main() {
     float light_strength = 20;
@@ -50,18 +185,47 @@ void main() {
     vec3 specular = specularFactor * u_specular_strength * u_light_color;
 
     //shadow calculation
-    vec3 projectedCoords = FragPosLightSpace.xyz / FragPosLightSpace.w;
-    projectedCoords = projectedCoords * 0.5 + 0.5;
-
-    // get closest depth value from light's perspective (using [0,1] range LightSpaceFragPos as coords)
-    float closestDepth = texture(u_depth_texture, projectedCoords.xy).r;
-
-    // get current linear depth as stored in the depth buffer
-    float currentDepth = projectedCoords.z;
-
-    float shadowScalar = (currentDepth - 0.003) < closestDepth ? 1.0 : u_shadows_influence;
-
-    vec3 colorResult = vec3(mix(vec4(u_color, 1.0f), texture(u_texture, FragUv), u_texture_influence)) * (ambient + (diffuse + specular) * shadowScalar * light_strength * 0.883 / (0.18 + 0.0 * lightDistance + 0.51 * lightDistance * lightDistance));
+    //the first shadow map that covers the fragment is used, since sun cascades are ordered from the sharpest to the widest
+    //maps whose edges are within the filter's reach are only used if no other one covers the fragment (cube faces overlap for this reason)
+    int shadowMap = -1;
+    vec3 projectedCoords = vec3(0.0);
+    float edgeMargin = 2.0 * SHADOW_REACH / float(textureSize(u_depth_texture, 0).x);
+
+    for (int i = 0; i < u_shadow_map_count && u_receives_shadows; ++i) {
+        vec4 fragPosLightSpace = u_shadow_view_projections[i] * vec4(FragPos, 1.0);
+        vec3 mapCoords = fragPosLightSpace.xyz / fragPosLightSpace.w * 0.5 + 0.5;
+
+        if (fragPosLightSpace.w <= 0.0 || any(lessThan(mapCoords, vec3(0.0))) || any(greaterThan(mapCoords, vec3(1.0))))
+            continue;
+
+        if (shadowMap < 0) {
+            shadowMap = i;
+            projectedCoords = mapCoords;
+        }
+
+        if (all(greaterThanEqual(mapCoords.xy, vec2(edgeMargin))) && all(lessThanEqual(mapCoords.xy, vec2(1.0 - edgeMargin)))) {
+            shadowMap = i;
+            projectedCoords = mapCoords;
+            break;
+        }
+    }
+
+    float shadowScalar = 1.0; //fragments outside of every shadow map are lit
+
+    //a fragment is only as lit as the least lit of the static & dynamic casters' layers let it be (which the exponential maps already combine)
+    if (shadowMap >= 0) {
+#if SHADOW_ESM
+        float lit = SampleExponentialShadow(projectedCoords, shadowMap, u_shadow_depth_params[shadowMap].x);
+#else
+        float staticLit = SampleShadow(projectedCoords, shadowMap, u_shadow_depth_params[shadowMap].x);
+        float dynamicLit = SampleShadow(projectedCoords, u_shadow_map_count + shadowMap, u_shadow_depth_params[shadowMap].x);
+        float lit = min(staticLit, dynamicLit);
+#endif
+
+        shadowScalar = mix(u_shadows_influence, 1.0, lit);
+    }
+
+    vec3 colorResult = vec3(mix(vec4(Color, 1.0f), texture(u_texture, FragUv), u_texture_influence)) * (ambient + (diffuse + specular) * shadowScalar * light_strength * 0.883 / (0.18 + 0.0 * lightDistance + 0.51 * lightDistance * lightDistance) + PointLighting(norm, viewDir));
 
     out_color = vec4(colorResult, u_alpha);
 }
\ No newline at end of file
@@ -2,11 +2,10 @@
 
 #version 330 core
 
-uniform mat4 u_model_transform; //model matrix
-uniform mat4 u_view_projection; //view projection matrix
+#include "../common/frame_uniforms.glsl"
 
-//uniform mat4 u_light_model_transform; //model matrix (from the light's perspective)
-uniform mat4 u_light_view_projection; //view projection matrix (from the light's perspective)
+uniform mat4 u_model_transform; //model matrix
+uniform vec3 u_color; //object color
 
 layout (location = 0) in vec3 vPos; //vertex input position
 layout (location = 1) in vec3 vNormal; //vertex input normal
@@ -14,15 +13,17 @@ layout (location = 2) in vec2 vUv; //vertex input uv
 
 out vec3 Normal;
 out vec3 FragPos;
-out vec4 FragPosLightSpace;
 out vec2 FragUv;
+out vec3 Color;
+
+invariant gl_Position; //so that it matches the depth prepass' depth exactly
 
 void main() {
     Normal = mat3(transpose(inverse(u_model_transform))) * vNormal; //we need to transform the normal with the normal matrix (https://learnopengl.com/Lighting/Basic-Lighting & http://www.lighthouse3d.com/tutorials/glsl-12-tutorial/the-normal-matrix/)
 
     FragPos = vec3(u_model_transform * vec4(vPos, 1.0));
-    FragPosLightSpace = u_light_view_projection * vec4(FragPos, 1.0);
     FragUv = vUv;
+    Color = u_color;
 
     gl_Position = u_view_projection * u_model_transform * vec4(vPos, 1.0); //gl_Position is a built-in property of a vertex shader
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+//instanced lit vertex shader, identical to the default one except for where the model matrix & color come from
+
+#version 330 core
+
+#include "../common/frame_uniforms.glsl"
+
+layout (location = 0) in vec3 vPos; //vertex input position
+layout (location = 1) in vec3 vNormal; //vertex input normal
+layout (location = 2) in vec2 vUv; //vertex input uv
+layout (location = 3) in mat4 vInstanceTransform; //per-instance model matrix (takes locations 3 to 6)
+layout (location = 7) in vec3 vInstanceColor; //per-instance color
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec2 FragUv;
+out vec3 Color;
+
+invariant gl_Position; //so that it matches the depth prepass' depth exactly
+
+void main() {
+    Normal = mat3(transpose(inverse(vInstanceTransform))) * vNormal; //we need to transform the normal with the normal matrix (https://learnopengl.com/Lighting/Basic-Lighting & http://www.lighthouse3d.com/tutorials/glsl-12-tutorial/the-normal-matrix/)
+
+    FragPos = vec3(vInstanceTransform * vec4(vPos, 1.0));
+    FragUv = vUv;
+    Color = vInstanceColor;
+
+    gl_Position = u_view_projection * vInstanceTransform * vec4(vPos, 1.0); //gl_Position is a built-in property of a vertex shader
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+//separable gaussian blur of the exponential shadow maps, one axis per pass
+
+#version 330 core
+
+#include "../common/frame_uniforms.glsl"
+#include "../common/exponential_shadows.glsl"
+
+uniform int u_shadow_map; //index of the shadow map being blurred
+
+#if ESM_HORIZONTAL
+uniform sampler2DArray u_depth_texture; //light screen depth textures, read as is (the static casters' layer of each shadow map, then their dynamic casters' layer)
+#else
+uniform sampler2D u_texture; //horizontal pass' result
+#endif
+
+layout(location = 0) out float out_occluders; //blurred exp(ESM_EXPONENT * occluder depth)
+
+const float BLUR_WEIGHTS[ESM_BLUR_RADIUS + 1] = float[](0.2270270270, 0.1945945946, 0.1216216216, 0.0540540541, 0.0162162162);
+
+#if ESM_HORIZONTAL
+//exponential of the nearest occluder's depth, of either layer
+float Occluder(ivec2 texel) {
+    texel = clamp(texel, ivec2(0), textureSize(u_depth_texture, 0).xy - 1);
+
+    float staticDepth = texelFetch(u_depth_texture, ivec3(texel, u_shadow_map), 0).r;
+    float dynamicDepth = texelFetch(u_depth_texture, ivec3(texel, u_shadow_map_count + u_shadow_map), 0).r;
+
+    return exp(ESM_EXPONENT * LinearShadowDepth(min(staticDepth, dynamicDepth), u_shadow_depth_params[u_shadow_map].y));
+}
+
+//box filter of the shadow map texels covered by an exponential map texel (averaged after the exponential, so that the result stays filterable)
+float DownsampledOccluders(ivec2 texel) {
+    float occluders = 0.0;
+
+    for (int x = 0; x < ESM_DOWNSAMPLE; ++x)
+        for (int y = 0; y < ESM_DOWNSAMPLE; ++y)
+            occluders += Occluder(texel * ESM_DOWNSAMPLE + ivec2(x, y));
+
+    return occluders / float(ESM_DOWNSAMPLE * ESM_DOWNSAMPLE);
+}
+#else
+float DownsampledOccluders(ivec2 texel) {
+    return texelFetch(u_texture, clamp(texel, ivec2(0), textureSize(u_texture, 0) - 1), 0).r;
+}
+#endif
+
+//entrypoint
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+#if ESM_HORIZONTAL
+    ivec2 direction = ivec2(1, 0);
+#else
+    ivec2 direction = ivec2(0, 1);
+#endif
+
+    float occluders = DownsampledOccluders(texel) * BLUR_WEIGHTS[0];
+
+    for (int i = 1; i <= ESM_BLUR_RADIUS; ++i)
+        occluders += (DownsampledOccluders(texel + direction * i) + DownsampledOccluders(texel - direction * i)) * BLUR_WEIGHTS[i];
+
+    out_occluders = occluders;
+}
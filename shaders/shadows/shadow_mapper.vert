@@ -2,12 +2,10 @@
 
 #version 330 core
 
-uniform mat4 u_model_transform; //model matrix (from the light's perspective)
-uniform mat4 u_view_projection; //view projection matrix (from the light's perspective)
+uniform mat4 u_model_transform; //model matrix
 
-layout (location = 0) in vec3 vPos; //vertex input position
-layout (location = 1) in vec3 vNormal; //vertex input normal
+layout (location = 0) in vec3 vPos; //vertex input position (the only attribute of the position-only stream)
 
 void main() {
-    gl_Position = u_view_projection * u_model_transform * vec4(vPos, 1.0); //gl_Position is a built-in property of a vertex shader
-}
\ No newline at end of file
+    gl_Position = u_model_transform * vec4(vPos, 1.0); //in world space, each shadow map's view projection is applied by the geometry shader
+}
@@ -0,0 +1,11 @@
+//instanced shadow mapper vertex shader, identical to the default one except for where the model matrix comes from
+
+#version 330 core
+
+layout (location = 0) in vec3 vPos; //vertex input position
+layout (location = 1) in vec3 vNormal; //vertex input normal
+layout (location = 3) in mat4 vInstanceTransform; //per-instance model matrix (takes locations 3 to 6)
+
+void main() {
+    gl_Position = vInstanceTransform * vec4(vPos, 1.0); //in world space, each shadow map's view projection is applied by the geometry shader
+}
@@ -0,0 +1,578 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <array>
+#include <limits>
+#include <algorithm>
+#include "glm/common.hpp"
+
+int BoundingVolumeHierarchy::Insert(const Bounds &_bounds, uint32_t _mask, uint32_t _userData) {
+    int proxy;
+
+    if (!free_proxies.empty()) {
+        proxy = free_proxies.back();
+        free_proxies.pop_back();
+    } else {
+        proxy = (int)proxies.size();
+        proxies.emplace_back();
+    }
+
+    const int leaf = AllocateNode();
+
+    nodes[leaf].bounds = Fatten(_bounds);
+    nodes[leaf].mask = _mask;
+    nodes[leaf].proxy = proxy;
+
+    proxies[proxy] = {
+        .bounds = _bounds,
+        .mask = _mask,
+        .user_data = _userData,
+        .node = leaf,
+    };
+
+    InsertLeaf(leaf);
+
+    ++stats.proxies;
+
+    return proxy;
+}
+
+void BoundingVolumeHierarchy::Remove(int _proxy) {
+    const int leaf = proxies[_proxy].node;
+
+    RemoveLeaf(leaf);
+    FreeNode(leaf);
+
+    proxies[_proxy].node = NULL_NODE;
+    free_proxies.push_back(_proxy);
+
+    --stats.proxies;
+}
+
+bool BoundingVolumeHierarchy::Move(int _proxy, const Bounds &_bounds) {
+    Proxy &proxy = proxies[_proxy];
+    proxy.bounds = _bounds;
+
+    // still inside of its fattened box, so none of the tree's boxes have to change
+    if (nodes[proxy.node].bounds.Contains(_bounds))
+        return false;
+
+    const int leaf = proxy.node;
+
+    RemoveLeaf(leaf);
+    nodes[leaf].bounds = Fatten(_bounds);
+    InsertLeaf(leaf);
+
+    ++stats.reinserted_proxies;
+    reinserted_since_check = true;
+
+    return true;
+}
+
+void BoundingVolumeHierarchy::Rebuild() {
+    build_proxies.clear();
+
+    for (size_t i = 0; i < proxies.size(); ++i) {
+        if (proxies[i].node != NULL_NODE)
+            build_proxies.push_back((int)i);
+    }
+
+    nodes.clear();
+    free_nodes.clear();
+
+    root = build_proxies.empty() ? NULL_NODE : BuildRange(0, build_proxies.size(), NULL_NODE);
+
+    rebuilt_cost = GetCost();
+    reinserted_since_check = false;
+
+    stats.height = root != NULL_NODE ? nodes[root].height : 0;
+    stats.cost_ratio = 1.0f;
+    ++stats.rebuilds;
+}
+
+bool BoundingVolumeHierarchy::RebuildIfDegraded() {
+    // reinsertions are the only thing that can degrade the tree
+    if (!reinserted_since_check)
+        return false;
+
+    reinserted_since_check = false;
+
+    stats.height = root != NULL_NODE ? nodes[root].height : 0;
+    stats.cost_ratio = rebuilt_cost > 0.0f ? GetCost() / rebuilt_cost : std::numeric_limits<float>::max();
+
+    if (stats.cost_ratio <= REBUILD_COST_RATIO)
+        return false;
+
+    Rebuild();
+
+    return true;
+}
+
+void BoundingVolumeHierarchy::QueryFrustums(std::span<const Frustum> _frustums, uint32_t _mask, std::vector<uint32_t> &_results) const {
+    if (root == NULL_NODE)
+        return;
+
+    ++stats.queries;
+
+    stack.clear();
+    stack.push_back(root);
+
+    while (!stack.empty()) {
+        const int index = stack.back();
+        stack.pop_back();
+
+        ++stats.visited_nodes;
+
+        const Node &node = nodes[index];
+
+        if ((node.mask & _mask) == 0)
+            continue;
+
+        bool intersects = false;
+        bool contained = false;
+
+        for (const auto &frustum : _frustums) {
+            if (!frustum.Intersects(node.bounds))
+                continue;
+
+            intersects = true;
+
+            if (frustum.Contains(node.bounds)) {
+                contained = true;
+                break;
+            }
+        }
+
+        if (!intersects)
+            continue;
+
+        // a subtree entirely inside of a frustum is taken as a whole, without testing anything below it
+        if (contained) {
+            CollectSubtree(index, _mask, _results);
+            continue;
+        }
+
+        if (node.IsLeaf()) {
+            const Proxy &proxy = proxies[node.proxy];
+
+            if (std::any_of(_frustums.begin(), _frustums.end(), [&](const Frustum &_frustum) { return _frustum.Intersects(proxy.bounds); }))
+                _results.push_back(proxy.user_data);
+
+            continue;
+        }
+
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+    }
+}
+
+void BoundingVolumeHierarchy::QuerySphere(const glm::vec3 &_center, float _radius, uint32_t _mask, std::vector<uint32_t> &_results) const {
+    if (root == NULL_NODE)
+        return;
+
+    ++stats.queries;
+
+    const auto overlaps = [&](const Bounds &_bounds) {
+        if (_bounds.IsEmpty())
+            return false;
+
+        const glm::vec3 offset = glm::clamp(_center, _bounds.min, _bounds.max) - _center;
+
+        return glm::dot(offset, offset) <= _radius * _radius;
+    };
+
+    stack.clear();
+    stack.push_back(root);
+
+    while (!stack.empty()) {
+        const int index = stack.back();
+        stack.pop_back();
+
+        ++stats.visited_nodes;
+
+        const Node &node = nodes[index];
+
+        if ((node.mask & _mask) == 0 || !overlaps(node.bounds))
+            continue;
+
+        if (node.IsLeaf()) {
+            const Proxy &proxy = proxies[node.proxy];
+
+            if (overlaps(proxy.bounds))
+                _results.push_back(proxy.user_data);
+
+            continue;
+        }
+
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+    }
+}
+
+void BoundingVolumeHierarchy::QueryMask(uint32_t _mask, std::vector<uint32_t> &_results) const {
+    if (root == NULL_NODE)
+        return;
+
+    ++stats.queries;
+
+    CollectSubtree(root, _mask, _results);
+}
+
+std::optional<BoundingVolumeHierarchy::RayHit> BoundingVolumeHierarchy::Raycast(const glm::vec3 &_origin, const glm::vec3 &_direction, float _maxDistance, uint32_t _mask) const {
+    if (root == NULL_NODE)
+        return std::nullopt;
+
+    ++stats.queries;
+
+    // divisions by zero are fine, the slabs of axes the ray is parallel to are then either never or always crossed
+    const glm::vec3 inverse_direction = glm::vec3(1.0f) / _direction;
+
+    std::optional<RayHit> closest_hit;
+    float closest_distance = _maxDistance;
+
+    stack.clear();
+    stack.push_back(root);
+
+    while (!stack.empty()) {
+        const int index = stack.back();
+        stack.pop_back();
+
+        ++stats.visited_nodes;
+
+        const Node &node = nodes[index];
+        float distance;
+
+        // also skips the subtrees that are further than the closest hit so far
+        if ((node.mask & _mask) == 0 || !RayIntersects(node.bounds, _origin, inverse_direction, closest_distance, distance))
+            continue;
+
+        if (node.IsLeaf()) {
+            const Proxy &proxy = proxies[node.proxy];
+
+            if (RayIntersects(proxy.bounds, _origin, inverse_direction, closest_distance, distance)) {
+                closest_distance = distance;
+                closest_hit = RayHit{.user_data = proxy.user_data, .distance = distance};
+            }
+
+            continue;
+        }
+
+        // the nearest child is visited first, so that it shrinks the search for the other one
+        float left_distance, right_distance;
+        const bool left_hit = RayIntersects(nodes[node.left].bounds, _origin, inverse_direction, closest_distance, left_distance);
+        const bool right_hit = RayIntersects(nodes[node.right].bounds, _origin, inverse_direction, closest_distance, right_distance);
+
+        if (left_hit && right_hit) {
+            stack.push_back(left_distance < right_distance ? node.right : node.left);
+            stack.push_back(left_distance < right_distance ? node.left : node.right);
+        } else if (left_hit) {
+            stack.push_back(node.left);
+        } else if (right_hit) {
+            stack.push_back(node.right);
+        }
+    }
+
+    return closest_hit;
+}
+
+void BoundingVolumeHierarchy::ResetStats() {
+    stats.reinserted_proxies = 0;
+    stats.queries = 0;
+    stats.visited_nodes = 0;
+}
+
+int BoundingVolumeHierarchy::AllocateNode() {
+    int index;
+
+    if (!free_nodes.empty()) {
+        index = free_nodes.back();
+        free_nodes.pop_back();
+    } else {
+        index = (int)nodes.size();
+        nodes.emplace_back();
+    }
+
+    nodes[index] = Node();
+
+    return index;
+}
+
+void BoundingVolumeHierarchy::FreeNode(int _node) {
+    // marked, so that the cost only sums the nodes that are in use
+    nodes[_node].height = -1;
+    free_nodes.push_back(_node);
+}
+
+void BoundingVolumeHierarchy::InsertLeaf(int _leaf) {
+    if (root == NULL_NODE) {
+        root = _leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    const Bounds leaf_bounds = nodes[_leaf].bounds;
+
+    // descends towards the sibling that costs the least surface area, every node on the way growing by the leaf's box anyway
+    int sibling = root;
+
+    while (!nodes[sibling].IsLeaf()) {
+        const Node &node = nodes[sibling];
+
+        const float combined_area = SurfaceArea(Union(node.bounds, leaf_bounds));
+
+        // pairing the leaf with this whole node creates a parent as large as both
+        const float pair_cost = 2.0f * combined_area;
+
+        // growth of this node, inherited by anything the leaf ends up under
+        const float inherited_cost = 2.0f * (combined_area - SurfaceArea(node.bounds));
+
+        const auto child_cost = [&](int _child) {
+            const float area = SurfaceArea(Union(nodes[_child].bounds, leaf_bounds));
+
+            return nodes[_child].IsLeaf() ? area + inherited_cost : area - SurfaceArea(nodes[_child].bounds) + inherited_cost;
+        };
+
+        const float left_cost = child_cost(node.left);
+        const float right_cost = child_cost(node.right);
+
+        if (pair_cost < left_cost && pair_cost < right_cost)
+            break;
+
+        sibling = left_cost < right_cost ? node.left : node.right;
+    }
+
+    const int old_parent = nodes[sibling].parent;
+    const int new_parent = AllocateNode();
+
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].left = sibling;
+    nodes[new_parent].right = _leaf;
+
+    nodes[sibling].parent = new_parent;
+    nodes[_leaf].parent = new_parent;
+
+    if (old_parent == NULL_NODE)
+        root = new_parent;
+    else if (nodes[old_parent].left == sibling)
+        nodes[old_parent].left = new_parent;
+    else
+        nodes[old_parent].right = new_parent;
+
+    Refit(new_parent);
+}
+
+void BoundingVolumeHierarchy::RemoveLeaf(int _leaf) {
+    if (_leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    // the leaf's parent goes away with it, its sibling taking its place
+    const int parent = nodes[_leaf].parent;
+    const int grand_parent = nodes[parent].parent;
+    const int sibling = nodes[parent].left == _leaf ? nodes[parent].right : nodes[parent].left;
+
+    nodes[sibling].parent = grand_parent;
+    FreeNode(parent);
+
+    if (grand_parent == NULL_NODE) {
+        root = sibling;
+        return;
+    }
+
+    if (nodes[grand_parent].left == parent)
+        nodes[grand_parent].left = sibling;
+    else
+        nodes[grand_parent].right = sibling;
+
+    Refit(grand_parent);
+}
+
+void BoundingVolumeHierarchy::Refit(int _node) {
+    for (int index = _node; index != NULL_NODE; index = nodes[index].parent) {
+        Node &node = nodes[index];
+        const Node &left = nodes[node.left];
+        const Node &right = nodes[node.right];
+
+        node.bounds = Union(left.bounds, right.bounds);
+        node.height = 1 + std::max(left.height, right.height);
+        node.mask = left.mask | right.mask;
+    }
+}
+
+int BoundingVolumeHierarchy::BuildRange(size_t _begin, size_t _end, int _parent) {
+    const int index = AllocateNode();
+    nodes[index].parent = _parent;
+
+    if (_end - _begin == 1) {
+        const int proxy = build_proxies[_begin];
+
+        nodes[index].bounds = Fatten(proxies[proxy].bounds);
+        nodes[index].mask = proxies[proxy].mask;
+        nodes[index].proxy = proxy;
+        proxies[proxy].node = index;
+
+        return index;
+    }
+
+    const auto centroid = [&](int _proxy) { return proxies[_proxy].bounds.Center(); };
+
+    // proxies are split along the axis their centers spread the most over
+    Bounds centroid_bounds;
+
+    for (size_t i = _begin; i < _end; ++i)
+        centroid_bounds.Add(centroid(build_proxies[i]));
+
+    const glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+    const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+
+    const auto begin = build_proxies.begin() + (long)_begin;
+    const auto end = build_proxies.begin() + (long)_end;
+    auto middle = begin;
+
+    if (extent[axis] > 0.0f) {
+        struct Bin {
+            Bounds bounds;
+            int count = 0;
+        };
+
+        std::array<Bin, SAH_BINS> bins;
+
+        const auto bin_of = [&](int _proxy) {
+            return std::min(SAH_BINS - 1, (int)((centroid(_proxy)[axis] - centroid_bounds.min[axis]) / extent[axis] * SAH_BINS));
+        };
+
+        for (size_t i = _begin; i < _end; ++i) {
+            Bin &bin = bins[bin_of(build_proxies[i])];
+
+            bin.bounds.Add(proxies[build_proxies[i]].bounds);
+            ++bin.count;
+        }
+
+        // costs of every split between two bins, the left side swept forward & the right one backward
+        std::array<float, SAH_BINS - 1> right_costs{};
+        Bounds right_bounds;
+        int right_count = 0;
+
+        for (int i = SAH_BINS - 1; i > 0; --i) {
+            right_bounds.Add(bins[i].bounds);
+            right_count += bins[i].count;
+            right_costs[i - 1] = SurfaceArea(right_bounds) * (float)right_count;
+        }
+
+        Bounds left_bounds;
+        int left_count = 0;
+        int best_split = 1;
+        float best_cost = std::numeric_limits<float>::max();
+
+        for (int i = 1; i < SAH_BINS; ++i) {
+            left_bounds.Add(bins[i - 1].bounds);
+            left_count += bins[i - 1].count;
+
+            const float cost = SurfaceArea(left_bounds) * (float)left_count + right_costs[i - 1];
+
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_split = i;
+            }
+        }
+
+        middle = std::partition(begin, end, [&](int _proxy) { return bin_of(_proxy) < best_split; });
+    }
+
+    // every center is in the same place (or in the same bin), so the proxies are split in two halves instead
+    if (middle == begin || middle == end) {
+        middle = begin + (long)(_end - _begin) / 2;
+        std::nth_element(begin, middle, end, [&](int _a, int _b) { return centroid(_a)[axis] < centroid(_b)[axis]; });
+    }
+
+    const size_t middle_index = _begin + (size_t)(middle - begin);
+
+    const int left = BuildRange(_begin, middle_index, index);
+    const int right = BuildRange(middle_index, _end, index);
+
+    nodes[index].left = left;
+    nodes[index].right = right;
+    nodes[index].bounds = Union(nodes[left].bounds, nodes[right].bounds);
+    nodes[index].height = 1 + std::max(nodes[left].height, nodes[right].height);
+    nodes[index].mask = nodes[left].mask | nodes[right].mask;
+
+    return index;
+}
+
+void BoundingVolumeHierarchy::CollectSubtree(int _node, uint32_t _mask, std::vector<uint32_t> &_results) const {
+    const Node &node = nodes[_node];
+
+    ++stats.visited_nodes;
+
+    if ((node.mask & _mask) == 0)
+        return;
+
+    if (node.IsLeaf()) {
+        _results.push_back(proxies[node.proxy].user_data);
+        return;
+    }
+
+    CollectSubtree(node.left, _mask, _results);
+    CollectSubtree(node.right, _mask, _results);
+}
+
+float BoundingVolumeHierarchy::GetCost() const {
+    if (root == NULL_NODE)
+        return 0.0f;
+
+    float internal_area = 0.0f;
+
+    for (const auto &node : nodes) {
+        if (node.height > 0)
+            internal_area += SurfaceArea(node.bounds);
+    }
+
+    const float root_area = SurfaceArea(nodes[root].bounds);
+
+    return root_area > 0.0f ? internal_area / root_area : 0.0f;
+}
+
+float BoundingVolumeHierarchy::SurfaceArea(const Bounds &_bounds) {
+    if (_bounds.IsEmpty())
+        return 0.0f;
+
+    const glm::vec3 size = _bounds.max - _bounds.min;
+
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+Bounds BoundingVolumeHierarchy::Union(const Bounds &_a, const Bounds &_b) {
+    Bounds result = _a;
+    result.Add(_b);
+
+    return result;
+}
+
+Bounds BoundingVolumeHierarchy::Fatten(const Bounds &_bounds) {
+    if (_bounds.IsEmpty())
+        return _bounds;
+
+    return {.min = _bounds.min - glm::vec3(FAT_MARGIN), .max = _bounds.max + glm::vec3(FAT_MARGIN)};
+}
+
+bool BoundingVolumeHierarchy::RayIntersects(const Bounds &_bounds, const glm::vec3 &_origin, const glm::vec3 &_inverseDirection, float _maxDistance, float &_distance) {
+    if (_bounds.IsEmpty())
+        return false;
+
+    // distances to the box's slabs along every axis, the ray being inside of the box where it is inside of all of them
+    const glm::vec3 to_min = (_bounds.min - _origin) * _inverseDirection;
+    const glm::vec3 to_max = (_bounds.max - _origin) * _inverseDirection;
+
+    const glm::vec3 slab_entries = glm::min(to_min, to_max);
+    const glm::vec3 slab_exits = glm::max(to_min, to_max);
+
+    const float entry = std::max(std::max(slab_entries.x, slab_entries.y), std::max(slab_entries.z, 0.0f));
+    const float exit = std::min(std::min(slab_exits.x, slab_exits.y), std::min(slab_exits.z, _maxDistance));
+
+    if (entry > exit)
+        return false;
+
+    _distance = entry;
+
+    return true;
+}
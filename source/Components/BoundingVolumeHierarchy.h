@@ -0,0 +1,120 @@
+// Dynamic tree of axis-aligned boxes over the scene's objects, so that culling & spatial queries only visit the branches that can matter
+// Leaves are fattened by a margin, so that objects moving a little don't change the tree at all, while those that leave their box are reinserted
+// Reinsertion picks the sibling that grows the tree's surface area the least (SAH), and the whole tree is rebuilt top-down with binned SAH once it degraded too much
+
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include "glm/vec3.hpp"
+#include "Utility/Bounds.hpp"
+#include "Utility/Frustum.hpp"
+
+class BoundingVolumeHierarchy {
+public:
+    struct RayHit {
+    public:
+        uint32_t user_data;
+        float distance; // along the ray, to the entry point of the proxy's box (0 if the ray starts inside of it)
+    };
+
+    // Counters (for profiling purposes)
+    struct Stats {
+    public:
+        int proxies = 0;
+        int height = 0;
+        float cost_ratio = 1.0f; // tree's current SAH cost relative to its cost right after the last rebuild
+
+        // since the last reset
+        int reinserted_proxies = 0;
+        int queries = 0;
+        int visited_nodes = 0;
+
+        int rebuilds = 0; // since startup
+    };
+
+    inline constexpr static int NULL_NODE = -1;
+    inline constexpr static uint32_t ANY_MASK = ~0u;
+
+    inline constexpr static float FAT_MARGIN = 0.25f; // added around every leaf's box, in world units
+    inline constexpr static float REBUILD_COST_RATIO = 1.5f;
+    inline constexpr static int SAH_BINS = 12;
+
+private:
+    struct Node {
+    public:
+        Bounds bounds; // fattened for leaves
+        int parent = NULL_NODE;
+        int left = NULL_NODE, right = NULL_NODE; // both NULL_NODE for leaves
+        int height = 0; // 0 for leaves
+        uint32_t mask = 0; // every mask bit of the leaves below
+
+        int proxy = NULL_NODE; // only for leaves
+
+        [[nodiscard]] bool IsLeaf() const { return left == NULL_NODE; }
+    };
+
+    // proxies keep their ids for as long as they live, while the nodes they're in change with every reinsertion or rebuild
+    struct Proxy {
+    public:
+        Bounds bounds; // exact, as given
+        uint32_t mask = 0; // queries only return the proxies that share a bit with their own mask
+        uint32_t user_data = 0;
+        int node = NULL_NODE; // NULL_NODE once removed
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int> free_nodes;
+    std::vector<Proxy> proxies;
+    std::vector<int> free_proxies;
+
+    int root = NULL_NODE;
+
+    float rebuilt_cost = 0.0f; // SAH cost right after the last rebuild, as a reference of a good tree
+    bool reinserted_since_check = false;
+
+    // scratch storage of the queries & rebuilds
+    mutable std::vector<int> stack;
+    std::vector<int> build_proxies;
+
+public:
+    mutable Stats stats;
+
+public:
+    int Insert(const Bounds &_bounds, uint32_t _mask, uint32_t _userData); // returns the new proxy's id
+    void Remove(int _proxy);
+    bool Move(int _proxy, const Bounds &_bounds); // returns whether the proxy had to be reinserted, i.e. whether it left its fattened box
+
+    void Rebuild(); // top-down, with binned SAH
+    bool RebuildIfDegraded(); // to be called once moves are done (e.g. once per frame), returns whether it did rebuild
+
+    // every query appends the user data of the proxies it found, in no particular order
+    void QueryFrustums(std::span<const Frustum> _frustums, uint32_t _mask, std::vector<uint32_t> &_results) const; // proxies inside any of the frusta
+    void QuerySphere(const glm::vec3 &_center, float _radius, uint32_t _mask, std::vector<uint32_t> &_results) const;
+    void QueryMask(uint32_t _mask, std::vector<uint32_t> &_results) const; // every proxy that has any of the mask's bits
+    [[nodiscard]] std::optional<RayHit> Raycast(const glm::vec3 &_origin, const glm::vec3 &_direction, float _maxDistance, uint32_t _mask) const; // closest hit
+
+    [[nodiscard]] const Bounds &GetBounds(int _proxy) const { return proxies[_proxy].bounds; }
+
+    void ResetStats(); // the counters that are since the last reset
+
+private:
+    int AllocateNode();
+    void FreeNode(int _node);
+
+    void InsertLeaf(int _leaf);
+    void RemoveLeaf(int _leaf);
+    void Refit(int _node); // from a node up to the root
+
+    int BuildRange(size_t _begin, size_t _end, int _parent); // over build_proxies' range, returns the range's node
+    void CollectSubtree(int _node, uint32_t _mask, std::vector<uint32_t> &_results) const; // every leaf below a node, without testing them
+
+    [[nodiscard]] float GetCost() const; // sum of the internal nodes' surface areas, relative to the root's
+
+    [[nodiscard]] static float SurfaceArea(const Bounds &_bounds);
+    [[nodiscard]] static Bounds Union(const Bounds &_a, const Bounds &_b);
+    [[nodiscard]] static Bounds Fatten(const Bounds &_bounds);
+    [[nodiscard]] static bool RayIntersects(const Bounds &_bounds, const glm::vec3 &_origin, const glm::vec3 &_inverseDirection, float _maxDistance, float &_distance);
+};
@@ -169,8 +169,39 @@ glm::vec3 Camera::GetPosition() const {
     return cam_position;
 }
 
-glm::mat4 Camera::GetViewProjection() const {
-    return projection_matrix * view_matrix;
+const glm::mat4& Camera::GetView() const {
+    return view_matrix;
+}
+
+const glm::mat4& Camera::GetProjection() const {
+    return projection_matrix;
+}
+
+const glm::mat4& Camera::GetViewProjection() const {
+    return view_projection_matrix;
+}
+
+std::array<glm::vec3, 8> Camera::GetFrustumCorners(float _near, float _far) const {
+    //the corners of the NDC cube, brought back to world space through a projection that only covers the slice
+    const glm::mat4 inverse_slice_view_projection = glm::inverse(glm::perspective(glm::radians(Camera::FOV), viewport_width / viewport_height, _near, _far) * view_matrix);
+
+    std::array<glm::vec3, 8> corners;
+
+    for (int i = 0; i < 8; ++i) {
+        const glm::vec4 ndc_corner = glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f);
+        const glm::vec4 world_corner = inverse_slice_view_projection * ndc_corner;
+
+        corners[i] = glm::vec3(world_corner) / world_corner.w;
+    }
+
+    return corners;
+}
+
+glm::vec3 Camera::GetRayDirection(float _ndcX, float _ndcY) const {
+    //the point on the far plane, brought back to world space
+    const glm::vec4 world_point = glm::inverse(view_projection_matrix) * glm::vec4(_ndcX, _ndcY, 1.0f, 1.0f);
+
+    return glm::normalize(glm::vec3(world_point) / world_point.w - cam_position);
 }
 
 void Camera::UpdateView() {
@@ -182,8 +213,17 @@ void Camera::UpdateView() {
     cam_up = glm::normalize(glm::cross(cam_right, cam_forward));
 
     view_matrix = glm::lookAt(cam_position, cam_target, cam_up);
+
+    UpdateViewProjection();
 }
 
 void Camera::UpdateProjection() {
     projection_matrix = glm::perspective(glm::radians(Camera::FOV), viewport_width / viewport_height, NEAR_PLANE, FAR_PLANE);
+
+    UpdateViewProjection();
+}
+
+void Camera::UpdateViewProjection() {
+    view_projection_matrix = projection_matrix * view_matrix;
+    frustum = Frustum(view_projection_matrix);
 }
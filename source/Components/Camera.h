@@ -2,11 +2,13 @@
 
 #pragma once
 
+#include <array>
 #include <iostream>
 #include "glm/vec3.hpp"
 #include "glm/mat4x4.hpp"
 #include "glm/ext/matrix_transform.hpp"
 #include "glm/ext/matrix_clip_space.hpp"
+#include "Utility/Frustum.hpp"
 
 class Camera {
 public:
@@ -64,11 +66,17 @@ public:
     void SetTarget(const glm::vec3& _target);
 
     [[nodiscard]] glm::vec3 GetPosition() const;
-    [[nodiscard]] glm::mat4 GetViewProjection() const;
+    [[nodiscard]] const glm::mat4& GetView() const;
+    [[nodiscard]] const glm::mat4& GetProjection() const;
+    [[nodiscard]] const glm::mat4& GetViewProjection() const;
+    [[nodiscard]] const Frustum& GetFrustum() const { return frustum; } //world space planes of the view projection
+    [[nodiscard]] std::array<glm::vec3, 8> GetFrustumCorners(float _near, float _far) const; //world space corners of a slice of the view frustum
+    [[nodiscard]] glm::vec3 GetRayDirection(float _ndcX, float _ndcY) const; //world space direction from the camera's position through a point of the viewport (e.g. for picking)
 
 private:
     void UpdateView(); //for when the camera's rotation changes
     void UpdateProjection(); //for when the camera's viewport changes (mainly)
+    void UpdateViewProjection(); //for when either of the above changes
 
 private:
     glm::vec3 cam_position, default_cam_position;
@@ -83,4 +91,6 @@ private:
 
     glm::mat4 view_matrix = glm::mat4(1.0f);
     glm::mat4 projection_matrix = glm::mat4(1.0f);
+    glm::mat4 view_projection_matrix = glm::mat4(1.0f); // cached product of the two above
+    Frustum frustum; // extracted from the above, along with it
 };
@@ -0,0 +1,213 @@
+#include "ClusteredLights.h"
+
+#include <chrono>
+#include <algorithm>
+#include "glm/common.hpp"
+#include "glm/exponential.hpp"
+#include "GLStateCache.h"
+
+// replaces a streamed buffer's storage (so that the GPU can keep reading the previous one), then fills its used part
+static void UploadBuffer(GLuint _buffer, GLsizeiptr _capacity, const void *_data, GLsizeiptr _size) {
+    glBindBuffer(GL_TEXTURE_BUFFER, _buffer);
+    glBufferData(GL_TEXTURE_BUFFER, _capacity, nullptr, GL_STREAM_DRAW);
+
+    if (_size > 0)
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, _size, _data);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+// allocates a buffer of a fixed capacity, read by a buffer texture of the given texel format
+static void CreateBufferTexture(GLuint &_buffer, GLuint &_texture, GLsizeiptr _capacity, GLenum _format, int _unit) {
+    glGenBuffers(1, &_buffer);
+    UploadBuffer(_buffer, _capacity, nullptr, 0);
+
+    glGenTextures(1, &_texture);
+    GLStateCache::BindTexture(_unit, GL_TEXTURE_BUFFER, _texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, _format, _buffer);
+    GLStateCache::BindTexture(_unit, GL_TEXTURE_BUFFER, 0);
+}
+
+ClusteredLights::ClusteredLights() {
+    CreateBufferTexture(point_lights_buffer_o, point_lights_tex, MAX_LIGHTS * POINT_LIGHT_TEXELS * sizeof(glm::vec4), GL_RGBA32F, POINT_LIGHTS_UNIT);
+    CreateBufferTexture(light_grid_buffer_o, light_grid_tex, CLUSTER_COUNT * sizeof(std::array<uint32_t, 2>), GL_RG32UI, LIGHT_GRID_UNIT);
+    CreateBufferTexture(light_indices_buffer_o, light_indices_tex, MAX_LIGHT_INDICES * sizeof(uint16_t), GL_R16UI, LIGHT_INDICES_UNIT);
+
+    light_grid.resize(CLUSTER_COUNT);
+}
+
+ClusteredLights::~ClusteredLights() {
+    const std::array<GLuint, 3> buffers = {point_lights_buffer_o, light_grid_buffer_o, light_indices_buffer_o};
+    const std::array<GLuint, 3> textures = {point_lights_tex, light_grid_tex, light_indices_tex};
+
+    glDeleteTextures((GLsizei)textures.size(), textures.data());
+    glDeleteBuffers((GLsizei)buffers.size(), buffers.data());
+}
+
+void ClusteredLights::Update(std::span<const PointLight> _lights, const Camera &_camera) {
+    const auto binning_start_time = std::chrono::steady_clock::now();
+
+    if (_camera.GetProjection() != cluster_projection)
+        UpdateClusterBounds(_camera.GetProjection());
+
+    const size_t light_count = std::min(_lights.size(), (size_t)MAX_LIGHTS);
+    const glm::mat4 &view = _camera.GetView();
+
+    light_xs.resize(light_count);
+    light_ys.resize(light_count);
+    light_zs.resize(light_count);
+    light_radii.resize(light_count);
+    first_slices.resize(light_count);
+    last_slices.resize(light_count);
+    point_light_texels.resize(light_count * POINT_LIGHT_TEXELS);
+
+    // view space spheres, spread into one array per component
+    for (size_t i = 0; i < light_count; ++i) {
+        const PointLight &light = _lights[i];
+
+        light_xs[i] = view[0][0] * light.position.x + view[1][0] * light.position.y + view[2][0] * light.position.z + view[3][0];
+        light_ys[i] = view[0][1] * light.position.x + view[1][1] * light.position.y + view[2][1] * light.position.z + view[3][1];
+        light_zs[i] = view[0][2] * light.position.x + view[1][2] * light.position.y + view[2][2] * light.position.z + view[3][2];
+        light_radii[i] = light.radius;
+
+        point_light_texels[i * POINT_LIGHT_TEXELS] = glm::vec4(light.position, light.radius);
+        point_light_texels[i * POINT_LIGHT_TEXELS + 1] = glm::vec4(light.color, light.intensity);
+        point_light_texels[i * POINT_LIGHT_TEXELS + 2] = glm::vec4((float)light.shadow_tile, 0.0f, 0.0f, 0.0f);
+    }
+
+    // range of depth slices each sphere overlaps (none, for those entirely behind the camera)
+    const glm::vec4 depth_params = GetDepthParams();
+
+    for (size_t i = 0; i < light_count; ++i) {
+        const float depth = -light_zs[i];
+
+        first_slices[i] = GetSlice(depth - light_radii[i], depth_params);
+        last_slices[i] = depth + light_radii[i] < Camera::NEAR_PLANE ? -1 : GetSlice(depth + light_radii[i], depth_params);
+    }
+
+    light_indices.clear();
+    stats = {.lights = (int)light_count};
+
+    for (int z = 0; z < CLUSTER_COUNT_Z; ++z) {
+        // only the lights of this slice are tested against its clusters
+        slice_lights.clear();
+        slice_xs.clear();
+        slice_ys.clear();
+        slice_zs.clear();
+        slice_radii_squared.clear();
+
+        for (size_t i = 0; i < light_count; ++i) {
+            if (first_slices[i] > z || last_slices[i] < z)
+                continue;
+
+            slice_lights.push_back((uint16_t)i);
+            slice_xs.push_back(light_xs[i]);
+            slice_ys.push_back(light_ys[i]);
+            slice_zs.push_back(light_zs[i]);
+            slice_radii_squared.push_back(light_radii[i] * light_radii[i]);
+        }
+
+        const size_t slice_light_count = slice_lights.size();
+        slice_hits.resize(slice_light_count);
+
+        for (int y = 0; y < CLUSTER_COUNT_Y; ++y) {
+            for (int x = 0; x < CLUSTER_COUNT_X; ++x) {
+                const int cluster = x + CLUSTER_COUNT_X * (y + CLUSTER_COUNT_Y * z);
+                const Bounds &bounds = cluster_bounds[cluster];
+
+                auto &cell = light_grid[cluster];
+                cell[0] = (uint32_t)light_indices.size();
+
+                // squared distance from each sphere's center to the cluster's box, without any branch so that it vectorizes
+                for (size_t j = 0; j < slice_light_count; ++j) {
+                    const float dx = std::max(std::max(bounds.min.x - slice_xs[j], slice_xs[j] - bounds.max.x), 0.0f);
+                    const float dy = std::max(std::max(bounds.min.y - slice_ys[j], slice_ys[j] - bounds.max.y), 0.0f);
+                    const float dz = std::max(std::max(bounds.min.z - slice_zs[j], slice_zs[j] - bounds.max.z), 0.0f);
+
+                    slice_hits[j] = (uint8_t)(dx * dx + dy * dy + dz * dz <= slice_radii_squared[j]);
+                }
+
+                for (size_t j = 0; j < slice_light_count; ++j) {
+                    if (!slice_hits[j])
+                        continue;
+
+                    if (light_indices.size() < MAX_LIGHT_INDICES)
+                        light_indices.push_back(slice_lights[j]);
+                    else
+                        ++stats.dropped_light_indices;
+                }
+
+                cell[1] = (uint32_t)light_indices.size() - cell[0];
+                stats.max_cluster_lights = std::max(stats.max_cluster_lights, (int)cell[1]);
+            }
+        }
+    }
+
+    stats.light_indices = (int)light_indices.size();
+
+    UploadBuffer(point_lights_buffer_o, MAX_LIGHTS * POINT_LIGHT_TEXELS * sizeof(glm::vec4), point_light_texels.data(), (GLsizeiptr)(point_light_texels.size() * sizeof(glm::vec4)));
+    UploadBuffer(light_grid_buffer_o, CLUSTER_COUNT * sizeof(std::array<uint32_t, 2>), light_grid.data(), (GLsizeiptr)(light_grid.size() * sizeof(std::array<uint32_t, 2>)));
+    UploadBuffer(light_indices_buffer_o, MAX_LIGHT_INDICES * sizeof(uint16_t), light_indices.data(), (GLsizeiptr)(light_indices.size() * sizeof(uint16_t)));
+
+    stats.binning_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - binning_start_time).count();
+}
+
+void ClusteredLights::Bind() const {
+    GLStateCache::BindTexture(POINT_LIGHTS_UNIT, GL_TEXTURE_BUFFER, point_lights_tex);
+    GLStateCache::BindTexture(LIGHT_GRID_UNIT, GL_TEXTURE_BUFFER, light_grid_tex);
+    GLStateCache::BindTexture(LIGHT_INDICES_UNIT, GL_TEXTURE_BUFFER, light_indices_tex);
+}
+
+glm::vec4 ClusteredLights::GetDepthParams() {
+    const float scale = (float)CLUSTER_COUNT_Z / glm::log(Camera::FAR_PLANE / SLICE_NEAR_DEPTH);
+
+    return {Camera::NEAR_PLANE, Camera::FAR_PLANE, scale, -glm::log(SLICE_NEAR_DEPTH) * scale};
+}
+
+glm::vec2 ClusteredLights::GetTileSize(int _viewportWidth, int _viewportHeight) {
+    return {(float)_viewportWidth / CLUSTER_COUNT_X, (float)_viewportHeight / CLUSTER_COUNT_Y};
+}
+
+void ClusteredLights::UpdateClusterBounds(const glm::mat4 &_projection) {
+    cluster_projection = _projection;
+
+    const glm::mat4 inverse_projection = glm::inverse(_projection);
+
+    for (int y = 0; y < CLUSTER_COUNT_Y; ++y) {
+        for (int x = 0; x < CLUSTER_COUNT_X; ++x) {
+            // view space rays through the tile's corners, scaled so that they are 1 unit deep
+            std::array<glm::vec3, 4> corner_rays;
+
+            for (int i = 0; i < 4; ++i) {
+                const glm::vec2 ndc_corner = glm::vec2((float)(x + (i & 1)) / CLUSTER_COUNT_X, (float)(y + (i >> 1)) / CLUSTER_COUNT_Y) * 2.0f - 1.0f;
+                const glm::vec4 near_corner = inverse_projection * glm::vec4(ndc_corner, -1.0f, 1.0f);
+
+                corner_rays[i] = glm::vec3(near_corner) / -near_corner.z;
+            }
+
+            for (int z = 0; z < CLUSTER_COUNT_Z; ++z) {
+                Bounds &bounds = cluster_bounds[x + CLUSTER_COUNT_X * (y + CLUSTER_COUNT_Y * z)];
+                bounds = Bounds();
+
+                for (const auto &corner_ray : corner_rays) {
+                    bounds.Add(corner_ray * GetSliceDepth(z));
+                    bounds.Add(corner_ray * GetSliceDepth(z + 1));
+                }
+            }
+        }
+    }
+}
+
+int ClusteredLights::GetSlice(float _viewDepth, const glm::vec4 &_depthParams) {
+    const auto slice = (int)glm::floor(glm::log(std::max(_viewDepth, SLICE_NEAR_DEPTH)) * _depthParams.z + _depthParams.w);
+
+    return std::clamp(slice, 0, CLUSTER_COUNT_Z - 1);
+}
+
+float ClusteredLights::GetSliceDepth(int _slice) {
+    // the first slice also covers everything in front of the exponential ones
+    if (_slice <= 0)
+        return Camera::NEAR_PLANE;
+
+    return SLICE_NEAR_DEPTH * glm::pow(Camera::FAR_PLANE / SLICE_NEAR_DEPTH, (float)_slice / CLUSTER_COUNT_Z);
+}
@@ -0,0 +1,104 @@
+// Bins point lights into a 3D grid of clusters over the camera's frustum, so that each fragment only loops over the lights that can reach it
+// Clusters are screen tiles split in depth slices (exponentially, so that they stay roughly cubic), whose lights are found on the CPU every frame
+// Lights, the cluster grid & the light indices are uploaded as buffer textures, since there are no storage buffers in OpenGL 3.3
+
+#pragma once
+
+#include <array>
+#include <span>
+#include <vector>
+#include <cstdint>
+#include "glad/glad.h"
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "Camera.h"
+#include "Utility/Bounds.hpp"
+
+class ClusteredLights {
+public:
+    struct PointLight {
+    public:
+        glm::vec3 position = glm::vec3(0.0f);
+        float radius = 1.0f; // past which the light has no influence at all
+        glm::vec3 color = glm::vec3(1.0f);
+        float intensity = 1.0f;
+        int shadow_tile = -1; // first of its cube faces' tiles in the shadow atlas (see ShadowAtlas), -1 for an unshadowed light
+    };
+
+    // Counters of the last binning (for profiling purposes)
+    struct Stats {
+    public:
+        int lights = 0;
+        int light_indices = 0;
+        int dropped_light_indices = 0; // past MAX_LIGHT_INDICES, those lights are missing from their clusters
+        int max_cluster_lights = 0;
+        double binning_ms = 0.0;
+    };
+
+    // has to match the lit shaders' cluster lookups, which get it through FrameUniforms
+    inline constexpr static int CLUSTER_COUNT_X = 16;
+    inline constexpr static int CLUSTER_COUNT_Y = 9;
+    inline constexpr static int CLUSTER_COUNT_Z = 24;
+    inline constexpr static int CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+
+    // depth slices are exponential from here to the camera's far plane, anything closer is in the first one
+    inline constexpr static float SLICE_NEAR_DEPTH = 1.0f;
+
+    // light indices are 16 bits, and a buffer texture is only guaranteed to hold 65536 texels
+    inline constexpr static int MAX_LIGHTS = 4096;
+    inline constexpr static int MAX_LIGHT_INDICES = 65536;
+
+    // has to match the lit shaders' lookups
+    inline constexpr static int POINT_LIGHT_TEXELS = 3;
+
+    // texture units the buffer textures are bound to, right after the shadow maps & the object texture
+    inline constexpr static int POINT_LIGHTS_UNIT = 2;
+    inline constexpr static int LIGHT_GRID_UNIT = 3;
+    inline constexpr static int LIGHT_INDICES_UNIT = 4;
+
+private:
+    // a buffer & the texture that reads it, for each of the three lists
+    GLuint point_lights_buffer_o = 0, point_lights_tex = 0; // 3 RGBA32F texels per light: position & radius, color & intensity, then shadow tile
+    GLuint light_grid_buffer_o = 0, light_grid_tex = 0; // 1 RG32UI texel per cluster: offset & count of its lights in the indices
+    GLuint light_indices_buffer_o = 0, light_indices_tex = 0; // 1 R16UI texel per light of each cluster
+
+    // view space bounds of every cluster, which only change with the camera's projection
+    std::array<Bounds, CLUSTER_COUNT> cluster_bounds;
+    glm::mat4 cluster_projection = glm::mat4(0.0f);
+
+    // structure of arrays of the lights' view space spheres, so that the binning loops over them vectorize
+    std::vector<float> light_xs, light_ys, light_zs, light_radii;
+    std::vector<int> first_slices, last_slices;
+
+    // same, for the lights of the slice being binned
+    std::vector<float> slice_xs, slice_ys, slice_zs, slice_radii_squared;
+    std::vector<uint16_t> slice_lights;
+    std::vector<uint8_t> slice_hits;
+
+    std::vector<glm::vec4> point_light_texels;
+    std::vector<std::array<uint32_t, 2>> light_grid;
+    std::vector<uint16_t> light_indices;
+
+public:
+    Stats stats;
+
+public:
+    ClusteredLights();
+    ~ClusteredLights();
+
+    ClusteredLights(const ClusteredLights &) = delete;
+    ClusteredLights &operator=(const ClusteredLights &) = delete;
+
+    void Update(std::span<const PointLight> _lights, const Camera &_camera); // bins the lights for the camera's current view & uploads the result
+    void Bind() const; // binds the buffer textures to their units
+
+    [[nodiscard]] static glm::vec4 GetDepthParams(); // camera near & far planes, then the scale & bias that turn a log view depth into a slice
+    [[nodiscard]] static glm::vec2 GetTileSize(int _viewportWidth, int _viewportHeight); // in pixels
+
+private:
+    void UpdateClusterBounds(const glm::mat4 &_projection);
+    [[nodiscard]] static int GetSlice(float _viewDepth, const glm::vec4 &_depthParams); // same as the lit shaders' lookup
+    [[nodiscard]] static float GetSliceDepth(int _slice); // near depth of a slice
+};
@@ -0,0 +1,18 @@
+#include "FrameUniforms.h"
+
+FrameUniforms::FrameUniforms() {
+    // allocates the block's storage once, it is only ever overwritten afterwards
+    glGenBuffers(1, &uniform_buffer_o);
+    glBindBuffer(GL_UNIFORM_BUFFER, uniform_buffer_o);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Data), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // every program's FrameUniforms block is pointed at this binding when it is linked (see Shader::Library::AddProgram)
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, uniform_buffer_o);
+}
+
+void FrameUniforms::Upload(const Data &_data) const {
+    glBindBuffer(GL_UNIFORM_BUFFER, uniform_buffer_o);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Data), &_data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,62 @@
+// Uniforms that only change once per pass (camera & light), shared by every program through a std140 uniform block
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "glad/glad.h"
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+
+class FrameUniforms {
+public:
+    inline constexpr static int MAX_SHADOW_MAPS = 6;
+
+    // Mirrors the FrameUniforms block declared in the shaders, member for member
+    // Every vec3 is followed by a float, so that it fills the vec3's 16-byte std140 slot
+    // MAX_SHADOW_MAPS has to match the array size declared in the shaders (and the shadow mapper geometry shader's max_vertices)
+    struct Data {
+    public:
+        glm::mat4 view_projection = glm::mat4(1.0f);
+
+        glm::vec3 cam_pos = glm::vec3(0.0f);
+        float ambient_strength = 0.0f;
+
+        glm::vec3 light_pos = glm::vec3(0.0f);
+        float specular_strength = 0.0f;
+
+        glm::vec3 light_color = glm::vec3(1.0f);
+        float shadows_influence = 1.0f;
+
+        // one per shadow map (see Light::GetShadowMapCount), shared by its static & dynamic layers
+        std::array<glm::mat4, MAX_SHADOW_MAPS> shadow_view_projections{};
+        std::array<glm::vec4, MAX_SHADOW_MAPS> shadow_depth_params{}; // depth bias, then near over far plane ratio (see Light::GetShadowDepthRatio), z & w unused
+        int shadow_map_count = 1;
+
+        // point lights' cluster grid (see ClusteredLights)
+        int cluster_count_x = 1;
+        int cluster_count_y = 1;
+        int cluster_count_z = 1;
+        glm::vec4 cluster_depth_params = glm::vec4(0.0f); // camera near & far planes, then the log depth to slice scale & bias
+        glm::vec2 cluster_tile_size = glm::vec2(1.0f); // in pixels
+        float padding[2] = {}; // std140 rounds the block's size up to 16 bytes
+    };
+
+    static_assert(offsetof(Data, cam_pos) == 64 && offsetof(Data, light_pos) == 80 && offsetof(Data, light_color) == 96 &&
+                  offsetof(Data, shadow_view_projections) == 112 && offsetof(Data, shadow_depth_params) == 496 && offsetof(Data, shadow_map_count) == 592 &&
+                  offsetof(Data, cluster_count_x) == 596 && offsetof(Data, cluster_depth_params) == 608 && offsetof(Data, cluster_tile_size) == 624 && sizeof(Data) == 640,
+                  "FrameUniforms::Data must match the std140 layout of the FrameUniforms block");
+
+    inline constexpr static const char *BLOCK_NAME = "FrameUniforms";
+    inline constexpr static GLuint BINDING = 0;
+
+private:
+    GLuint uniform_buffer_o = 0;
+
+public:
+    FrameUniforms();
+
+    void Upload(const Data &_data) const; // replaces the whole block, to be called once per pass
+};
@@ -0,0 +1,43 @@
+#include "GLQuery.h"
+
+GLQuery::GLQuery(GLenum _target) {
+    target = _target;
+
+    glGenQueries((GLsizei)query_o.size(), query_o.data());
+}
+
+GLQuery::~GLQuery() {
+    glDeleteQueries((GLsizei)query_o.size(), query_o.data());
+}
+
+void GLQuery::Begin() {
+    // the query about to be reused was ended a frame ago, so its result is (almost always) ready by now
+    if (pending[current])
+        glGetQueryObjectui64v(query_o[current], GL_QUERY_RESULT, &last_result);
+
+    glBeginQuery(target, query_o[current]);
+}
+
+void GLQuery::End() {
+    glEndQuery(target);
+
+    pending[current] = true;
+    current = 1 - current;
+}
+
+bool GLQuery::PollLastEnded(GLuint64 &_result) const {
+    const int last = 1 - current;
+
+    if (!pending[last])
+        return false;
+
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(query_o[last], GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if (available == GL_FALSE)
+        return false;
+
+    glGetQueryObjectui64v(query_o[last], GL_QUERY_RESULT, &_result);
+
+    return true;
+}
@@ -0,0 +1,33 @@
+// Double-buffered OpenGL query (e.g. GL_TIME_ELAPSED or GL_SAMPLES_PASSED), so that reading a result never waits on the GPU
+// Results lag two frames behind: a query is only read back when it is about to be reused
+// The query ended last can also be polled, or handed to conditional rendering, without waiting on it either
+
+#pragma once
+
+#include <array>
+#include "glad/glad.h"
+
+class GLQuery {
+private:
+    GLenum target;
+
+    std::array<GLuint, 2> query_o{};
+    std::array<bool, 2> pending{};
+    int current = 0;
+
+    GLuint64 last_result = 0;
+
+public:
+    explicit GLQuery(GLenum _target);
+    ~GLQuery();
+
+    GLQuery(const GLQuery &) = delete;
+    GLQuery &operator=(const GLQuery &) = delete;
+
+    void Begin();
+    void End();
+
+    [[nodiscard]] GLuint64 GetResult() const { return last_result; } // latest result read back (0 until then)
+    [[nodiscard]] GLuint GetLastEnded() const { return query_o[1 - current]; } // e.g. for glBeginConditionalRender, only meaningful once End was called
+    bool PollLastEnded(GLuint64 &_result) const; // reads the result of the query ended last if the GPU is done with it, returns whether it was
+};
@@ -0,0 +1,154 @@
+#include "GLStateCache.h"
+
+GLStateCache::State GLStateCache::state;
+GLStateCache::Stats GLStateCache::stats;
+
+void GLStateCache::Invalidate() {
+    state = State();
+
+    for (auto &unit_textures : state.textures)
+        unit_textures.fill(UNKNOWN_NAME);
+}
+
+void GLStateCache::ResetStats() {
+    stats = {};
+}
+
+void GLStateCache::UseProgram(GLuint _program) {
+    if (Changed(state.program != _program)) {
+        glUseProgram(_program);
+        state.program = _program;
+    }
+}
+
+void GLStateCache::BindVertexArray(GLuint _vertexArray) {
+    if (Changed(state.vertex_array != _vertexArray)) {
+        glBindVertexArray(_vertexArray);
+        state.vertex_array = _vertexArray;
+    }
+}
+
+void GLStateCache::BindFramebuffer(GLuint _framebuffer) {
+    if (Changed(state.framebuffer != _framebuffer)) {
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        state.framebuffer = _framebuffer;
+    }
+}
+
+void GLStateCache::BindTexture(int _unit, GLenum _target, GLuint _texture) {
+    const auto target_it = std::find(TEXTURE_TARGETS.begin(), TEXTURE_TARGETS.end(), _target);
+    const bool tracked = _unit >= 0 && _unit < TEXTURE_UNIT_COUNT && target_it != TEXTURE_TARGETS.end();
+
+    GLuint *current_texture = tracked ? &state.textures[_unit][target_it - TEXTURE_TARGETS.begin()] : nullptr;
+
+    if (!Changed(current_texture == nullptr || *current_texture != _texture))
+        return;
+
+    // the active unit only matters to the bind itself, so it is only switched when a bind is issued
+    const GLenum texture_unit = GL_TEXTURE0 + _unit;
+
+    if (Changed(state.active_texture_unit != texture_unit)) {
+        glActiveTexture(texture_unit);
+        state.active_texture_unit = texture_unit;
+    }
+
+    glBindTexture(_target, _texture);
+
+    if (current_texture != nullptr)
+        *current_texture = _texture;
+}
+
+void GLStateCache::Viewport(GLint _x, GLint _y, GLsizei _width, GLsizei _height) {
+    const std::array<GLint, 4> viewport = {_x, _y, _width, _height};
+
+    if (Changed(state.viewport != viewport)) {
+        glViewport(_x, _y, _width, _height);
+        state.viewport = viewport;
+    }
+}
+
+void GLStateCache::Scissor(GLint _x, GLint _y, GLsizei _width, GLsizei _height) {
+    const std::array<GLint, 4> scissor = {_x, _y, _width, _height};
+
+    if (Changed(state.scissor != scissor)) {
+        glScissor(_x, _y, _width, _height);
+        state.scissor = scissor;
+    }
+}
+
+void GLStateCache::SetScissorTest(bool _enabled) {
+    SetCapability(GL_SCISSOR_TEST, state.scissor_test, _enabled);
+}
+
+void GLStateCache::LineWidth(float _width) {
+    if (Changed(state.line_width != _width)) {
+        glLineWidth(_width);
+        state.line_width = _width;
+    }
+}
+
+void GLStateCache::PointSize(float _size) {
+    if (Changed(state.point_size != _size)) {
+        glPointSize(_size);
+        state.point_size = _size;
+    }
+}
+
+void GLStateCache::SetBlend(bool _enabled) {
+    SetCapability(GL_BLEND, state.blend, _enabled);
+}
+
+void GLStateCache::BlendFunc(GLenum _source, GLenum _destination) {
+    if (Changed(state.blend_source != _source || state.blend_destination != _destination)) {
+        glBlendFunc(_source, _destination);
+        state.blend_source = _source;
+        state.blend_destination = _destination;
+    }
+}
+
+void GLStateCache::SetDepthTest(bool _enabled) {
+    SetCapability(GL_DEPTH_TEST, state.depth_test, _enabled);
+}
+
+void GLStateCache::DepthMask(bool _enabled) {
+    if (Changed(state.depth_mask != (int8_t)_enabled)) {
+        glDepthMask(_enabled ? GL_TRUE : GL_FALSE);
+        state.depth_mask = (int8_t)_enabled;
+    }
+}
+
+void GLStateCache::DepthFunc(GLenum _func) {
+    if (Changed(state.depth_func != _func)) {
+        glDepthFunc(_func);
+        state.depth_func = _func;
+    }
+}
+
+void GLStateCache::ColorMask(bool _enabled) {
+    if (Changed(state.color_mask != (int8_t)_enabled)) {
+        const GLboolean mask = _enabled ? GL_TRUE : GL_FALSE;
+        glColorMask(mask, mask, mask, mask);
+        state.color_mask = (int8_t)_enabled;
+    }
+}
+
+bool GLStateCache::Changed(bool _changed) {
+    if (_changed)
+        ++stats.issued;
+    else
+        ++stats.elided;
+
+    return _changed;
+}
+
+void GLStateCache::SetCapability(GLenum _capability, int8_t &_current, bool _enabled) {
+    if (!Changed(_current != (int8_t)_enabled))
+        return;
+
+    if (_enabled)
+        glEnable(_capability);
+    else
+        glDisable(_capability);
+
+    _current = (int8_t)_enabled;
+}
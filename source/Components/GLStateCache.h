@@ -0,0 +1,94 @@
+// Thin layer over the OpenGL state machine: remembers the state it last set and skips calls that wouldn't change anything
+// Every bind & raster-state call of the renderer goes through here, otherwise the remembered state goes stale (see Invalidate)
+
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include "glad/glad.h"
+
+class GLStateCache {
+public:
+    // Calls issued to the driver versus elided because the state was already set (for profiling purposes)
+    struct Stats {
+    public:
+        int issued = 0;
+        int elided = 0;
+    };
+
+    inline constexpr static int TEXTURE_UNIT_COUNT = 16;
+
+private:
+    // tracked texture targets, every other target is always issued
+    inline constexpr static std::array<GLenum, 4> TEXTURE_TARGETS = {GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BUFFER};
+
+    // unknown values never match anything, so that the first call after an invalidation is always issued
+    inline constexpr static GLuint UNKNOWN_NAME = 0xFFFFFFFF;
+    inline constexpr static GLenum UNKNOWN_ENUM = 0xFFFFFFFF;
+    inline constexpr static int8_t UNKNOWN_FLAG = -1;
+
+    struct State {
+    public:
+        GLuint program = UNKNOWN_NAME;
+        GLuint vertex_array = UNKNOWN_NAME;
+        GLuint framebuffer = UNKNOWN_NAME;
+
+        GLenum active_texture_unit = UNKNOWN_ENUM;
+        std::array<std::array<GLuint, TEXTURE_TARGETS.size()>, TEXTURE_UNIT_COUNT> textures{};
+
+        std::array<GLint, 4> viewport = {-1, -1, -1, -1};
+        std::array<GLint, 4> scissor = {-1, -1, -1, -1};
+
+        float line_width = -1.0f;
+        float point_size = -1.0f;
+
+        int8_t blend = UNKNOWN_FLAG;
+        GLenum blend_source = UNKNOWN_ENUM;
+        GLenum blend_destination = UNKNOWN_ENUM;
+
+        int8_t scissor_test = UNKNOWN_FLAG;
+
+        int8_t depth_test = UNKNOWN_FLAG;
+        int8_t depth_mask = UNKNOWN_FLAG;
+        GLenum depth_func = UNKNOWN_ENUM;
+
+        int8_t color_mask = UNKNOWN_FLAG; // all channels at once, they are never masked separately
+    };
+
+    static State state;
+
+public:
+    static Stats stats;
+
+public:
+    GLStateCache() = delete;
+
+    static void Invalidate(); // forgets every remembered state, to be called after anything changed the GL state behind the cache's back
+    static void ResetStats();
+
+    static void UseProgram(GLuint _program);
+    static void BindVertexArray(GLuint _vertexArray);
+    static void BindFramebuffer(GLuint _framebuffer);
+
+    static void BindTexture(int _unit, GLenum _target, GLuint _texture); // also selects the unit as the active one, when needed
+
+    static void Viewport(GLint _x, GLint _y, GLsizei _width, GLsizei _height);
+    static void Scissor(GLint _x, GLint _y, GLsizei _width, GLsizei _height);
+    static void SetScissorTest(bool _enabled);
+    static void LineWidth(float _width);
+    static void PointSize(float _size);
+
+    static void SetBlend(bool _enabled);
+    static void BlendFunc(GLenum _source, GLenum _destination);
+
+    static void SetDepthTest(bool _enabled);
+    static void DepthMask(bool _enabled);
+    static void DepthFunc(GLenum _func);
+
+    static void ColorMask(bool _enabled);
+
+private:
+    static bool Changed(bool _changed); // counts the call as issued or elided, and returns whether it has to be issued
+    static void SetCapability(GLenum _capability, int8_t &_current, bool _enabled);
+};
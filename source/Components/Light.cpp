@@ -1,4 +1,7 @@
 #include "Light.h"
+
+#include "glm/common.hpp"
+#include "glm/exponential.hpp"
 #include "Utility/Transform.hpp"
 
 Light::Light(glm::vec3 _position, glm::vec3 _color, float _ambientStrength, float _specularStrength) {
@@ -8,21 +11,129 @@ Light::Light(glm::vec3 _position, glm::vec3 _color, float _ambientStrength, floa
     specular_strength = _specularStrength;
 
     UpdateView();
-    UpdateProjection();
 }
 
 void Light::SetPosition(const glm::vec3 &_position) {
+    if (position == _position)
+        return;
+
     position = _position;
 
     UpdateView();
 }
 
 void Light::SetTarget(const glm::vec3 &_target) {
-    position = _target;
+    if (target == _target)
+        return;
+
+    target = _target;
 
     UpdateView();
 }
 
+void Light::SetMode(Light::Mode _mode) {
+    shadow_dirty |= mode != _mode;
+    mode = _mode;
+}
+
+void Light::SetCascadeCount(int _count) {
+    _count = glm::clamp(_count, MIN_CASCADES, MAX_CASCADES);
+
+    shadow_dirty |= mode == Mode::SUN && cascade_count != _count;
+    cascade_count = _count;
+}
+
+void Light::SetShadowMapSize(int _size) {
+    _size = glm::clamp(_size, MIN_SHADOW_MAP_SIZE, MAX_SHADOW_MAP_SIZE);
+
+    shadow_dirty |= shadow_map_size != _size;
+    shadow_map_size = _size;
+}
+
+void Light::FitShadowBounds(const Bounds &_bounds) {
+    Bounds snapped_bounds;
+
+    if (!_bounds.IsEmpty()) {
+        snapped_bounds.min = glm::floor(_bounds.min / BOUNDS_SNAP) * BOUNDS_SNAP;
+        snapped_bounds.max = glm::ceil(_bounds.max / BOUNDS_SNAP) * BOUNDS_SNAP;
+    }
+
+    if (snapped_bounds == shadow_bounds)
+        return;
+
+    shadow_bounds = snapped_bounds;
+
+    // the sun's cascades are refitted on their next update
+    shadow_dirty = true;
+    UpdateView();
+}
+
+void Light::UpdateCascades(const Camera &_camera) {
+    const float shadow_near = Camera::NEAR_PLANE;
+    const float shadow_far = glm::min(SUN_SHADOW_DISTANCE, Camera::FAR_PLANE);
+
+    const glm::vec3 sun_direction = glm::normalize(target - position);
+    const glm::vec3 sun_up = glm::abs(glm::dot(sun_direction, Transforms::UP)) > 0.99f ? Transforms::FORWARD : Transforms::UP;
+
+    float slice_near = shadow_near;
+
+    for (int i = 0; i < cascade_count; ++i) {
+        // practical split scheme: logarithmic splits match the perspective's texel density, uniform ones keep the first slice from being tiny
+        const float split_ratio = (float)(i + 1) / (float)cascade_count;
+        const float uniform_split = shadow_near + (shadow_far - shadow_near) * split_ratio;
+        const float logarithmic_split = shadow_near * glm::pow(shadow_far / shadow_near, split_ratio);
+        const float slice_far = glm::mix(uniform_split, logarithmic_split, CASCADE_SPLIT_LAMBDA);
+
+        const auto corners = _camera.GetFrustumCorners(slice_near, slice_far);
+
+        // a bounding sphere doesn't change size when the camera rotates, so the cascade's texels don't either
+        glm::vec3 center = glm::vec3(0.0f);
+        for (const auto &corner : corners)
+            center += corner;
+        center /= (float)corners.size();
+
+        float radius = 0.0f;
+        for (const auto &corner : corners)
+            radius = glm::max(radius, glm::length(corner - center));
+        radius = glm::ceil(radius * 16.0f) / 16.0f;
+
+        // the depth range covers the slice, and every caster between it & the sun (but nothing past the shadow bounds)
+        float behind = radius;
+        float ahead = radius;
+
+        for (const auto &bounds_corner : shadow_bounds.IsEmpty() ? std::array<glm::vec3, 8>{} : shadow_bounds.Corners()) {
+            const float distance_along_sun = glm::dot(bounds_corner - center, sun_direction);
+
+            behind = glm::max(behind, -distance_along_sun);
+            ahead = glm::max(ahead, distance_along_sun);
+        }
+
+        const float depth_range = behind + ahead;
+
+        const glm::mat4 cascade_view = glm::lookAt(center - sun_direction * behind, center, sun_up);
+        glm::mat4 cascade_projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, depth_range);
+
+        // snaps the cascade to whole texels, so that shadow edges don't shimmer when the camera moves
+        const int cascade_map_size = GetShadowMapSize();
+        const float half_size = (float)cascade_map_size / 2.0f;
+        const glm::vec4 shadow_origin = cascade_projection * cascade_view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) * half_size;
+
+        cascade_projection[3][0] += (glm::round(shadow_origin.x) - shadow_origin.x) / half_size;
+        cascade_projection[3][1] += (glm::round(shadow_origin.y) - shadow_origin.y) / half_size;
+
+        const float texel_world_size = 2.0f * radius / (float)cascade_map_size;
+
+        // a still camera gives the exact same cascades, which keeps the cached shadow maps valid
+        const glm::mat4 cascade_view_projection = cascade_projection * cascade_view;
+        shadow_dirty |= cascade_view_projection != cascade_view_projections[i];
+
+        cascade_view_projections[i] = cascade_view_projection;
+        cascade_depth_biases[i] = (SUN_DEPTH_BIAS + texel_world_size) / depth_range;
+
+        slice_near = slice_far;
+    }
+}
+
 glm::vec3 Light::GetPosition() const {
     return position;
 }
@@ -35,18 +146,131 @@ glm::vec3 Light::GetColor() const {
     return color;
 }
 
-glm::mat4 Light::GetViewProjection() const {
-    return projection_matrix * view_matrix;
+const glm::mat4& Light::GetViewProjection() const {
+    return view_projection_matrix;
+}
+
+const glm::mat4& Light::GetShadowViewProjection(int _index) const {
+    switch (mode) {
+        case Mode::SUN:
+            return cascade_view_projections[_index];
+        case Mode::POINT:
+            return cube_face_view_projections[_index];
+        default:
+            return view_projection_matrix;
+    }
+}
+
+float Light::GetShadowDepthBias(int _index) const {
+    return mode == Mode::SUN ? cascade_depth_biases[_index] : DEPTH_BIAS;
+}
+
+float Light::GetShadowDepthRatio(int /*_index*/) const {
+    switch (mode) {
+        case Mode::SUN:
+            return 1.0f;
+        case Mode::POINT:
+            return cube_face_depth_ratio;
+        default:
+            return projection_depth_ratio;
+    }
 }
 
 void Light::UpdateView() {
-    light_forward = glm::normalize(position - target);
-    light_right = glm::normalize(glm::cross(light_forward, Transforms::UP));
+    // the perspective frustum is centered on what it has to cover
+    const glm::vec3 look_at = shadow_bounds.IsEmpty() ? target : shadow_bounds.Center();
+
+    light_forward = glm::normalize(position - look_at);
+    light_right = glm::normalize(glm::cross(light_forward, glm::abs(light_forward.y) > 0.99f ? Transforms::FORWARD : Transforms::UP));
     light_up = glm::normalize(glm::cross(light_right, light_forward));
 
-    view_matrix = glm::lookAt(position, target, light_up);
+    view_matrix = glm::lookAt(position, look_at, light_up);
+
+    // the fitted projection depends on where the light is
+    UpdateProjection();
 }
 
 void Light::UpdateProjection() {
-    projection_matrix = glm::perspective(glm::radians(Light::FOV), (float)Light::LIGHTMAP_SIZE / (float)Light::LIGHTMAP_SIZE, Light::NEAR_PLANE, Light::FAR_PLANE);
+    if (shadow_bounds.IsEmpty()) {
+        projection_matrix = glm::perspective(glm::radians(Light::FOV), 1.0f, Light::NEAR_PLANE, Light::FAR_PLANE);
+        projection_depth_ratio = Light::NEAR_PLANE / Light::FAR_PLANE;
+
+        UpdateViewProjection();
+        return;
+    }
+
+    // the narrowest (square) frustum that still contains every corner of the bounds, and only their depth range
+    float max_tangent = 0.0f;
+    float near_plane = Light::FAR_PLANE;
+    float far_plane = Light::NEAR_PLANE;
+    bool surrounded = false; // some of the bounds are beside or behind the light, so no frustum can contain them all
+
+    for (const auto &corner : shadow_bounds.Corners()) {
+        const glm::vec3 view_corner = glm::vec3(view_matrix * glm::vec4(corner, 1.0f));
+        const float depth = -view_corner.z;
+
+        far_plane = glm::max(far_plane, depth);
+
+        if (depth <= Light::NEAR_PLANE) {
+            surrounded = true;
+            continue;
+        }
+
+        near_plane = glm::min(near_plane, depth);
+        max_tangent = glm::max(max_tangent, glm::max(glm::abs(view_corner.x), glm::abs(view_corner.y)) / depth);
+    }
+
+    float fov = glm::degrees(2.0f * glm::atan(max_tangent));
+
+    if (surrounded) {
+        fov = Light::MAX_FOV;
+        near_plane = Light::NEAR_PLANE;
+    }
+
+    fov = glm::clamp(fov, 1.0f, Light::MAX_FOV);
+    near_plane = glm::clamp(near_plane, Light::NEAR_PLANE, Light::FAR_PLANE);
+    far_plane = glm::clamp(far_plane, near_plane + Light::NEAR_PLANE, Light::FAR_PLANE);
+
+    projection_matrix = glm::perspective(glm::radians(fov), 1.0f, near_plane, far_plane);
+    projection_depth_ratio = near_plane / far_plane;
+
+    UpdateViewProjection();
+}
+
+void Light::UpdateCubeFaces() {
+    // the faces only have to reach the farthest corner of the bounds
+    float far_plane = Light::FAR_PLANE;
+
+    if (!shadow_bounds.IsEmpty()) {
+        far_plane = 0.0f;
+
+        for (const auto &corner : shadow_bounds.Corners())
+            far_plane = glm::max(far_plane, glm::length(corner - position));
+
+        far_plane = glm::clamp(far_plane, 2.0f * Light::NEAR_PLANE, Light::FAR_PLANE);
+    }
+
+    const glm::mat4 face_projection = glm::perspective(glm::radians(Light::CUBE_FACE_FOV), 1.0f, Light::NEAR_PLANE, far_plane);
+    cube_face_depth_ratio = Light::NEAR_PLANE / far_plane;
+
+    // +X, -X, +Y, -Y, +Z & -Z, each with an up vector that isn't parallel to it
+    const std::array<std::array<glm::vec3, 2>, CUBE_FACE_COUNT> face_directions = {{
+        {glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)},
+        {glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)},
+        {glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)},
+        {glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)},
+        {glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f)},
+        {glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f)},
+    }};
+
+    for (int i = 0; i < CUBE_FACE_COUNT; ++i)
+        cube_face_view_projections[i] = face_projection * glm::lookAt(position, position + face_directions[i][0], face_directions[i][1]);
+}
+
+void Light::UpdateViewProjection() {
+    view_projection_matrix = projection_matrix * view_matrix;
+
+    UpdateCubeFaces();
+
+    shadow_dirty = true;
 }
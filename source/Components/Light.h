@@ -1,25 +1,56 @@
 #pragma once
 
+#include <array>
 #include "glm/vec3.hpp"
 #include "glm/mat4x4.hpp"
 #include "glm/ext/matrix_transform.hpp"
 #include "glm/ext/matrix_clip_space.hpp"
+#include "Camera.h"
+#include "Utility/Bounds.hpp"
 
 class Light {
 public:
+    enum class Mode {
+        PERSPECTIVE, // one perspective shadow frustum, from the light's position towards the shadow bounds (or its target, without any)
+        SUN, // directional, along the position-to-target direction, with cascades fitted to the camera's frustum
+        POINT, // omnidirectional, with one shadow map per cube face around the light's position
+    };
+
     float ambient_strength = 0.1f;
     float specular_strength = 0.5f;
 
-    inline static int LIGHTMAP_SIZE = 2048;
+    // shadow map resolution, changeable at runtime (sun cascades are half of it, since there are several of them)
+    inline constexpr static int MIN_SHADOW_MAP_SIZE = 512;
+    inline constexpr static int MAX_SHADOW_MAP_SIZE = 4096;
+    inline constexpr static int DEFAULT_SHADOW_MAP_SIZE = 2048;
+
+    // the perspective frustum is fitted to the shadow bounds, within these limits (and uses them as is without any bounds)
     inline constexpr static float FOV = 90.0f;
+    inline constexpr static float MAX_FOV = 150.0f;
     inline constexpr static float NEAR_PLANE = 0.1f;
     inline constexpr static float FAR_PLANE = 400.0f;
+    inline constexpr static float DEPTH_BIAS = 0.003f; // in the perspective shadow map's depth range
+
+    // shadow bounds are snapped outwards to this grid, so that small caster movements don't refit (and shimmer) the frustum
+    inline constexpr static float BOUNDS_SNAP = 0.5f;
+
+    // cascades are smaller than the perspective shadow map, but each only covers a slice of what the camera sees
+    inline constexpr static int MAX_CASCADES = 4;
+    inline constexpr static int MIN_CASCADES = 2;
+    inline constexpr static float SUN_SHADOW_DISTANCE = 80.0f; // from the camera, past which nothing is shadowed in sun mode
+    inline constexpr static float CASCADE_SPLIT_LAMBDA = 0.75f; // blend between uniform (0) & logarithmic (1) splits
+    inline constexpr static float SUN_DEPTH_BIAS = 0.02f; // in world units, on top of one texel's size
+
+    // cube faces are a bit wider than 90 degrees, so that a fragment is always far enough from one face's edges for its filtering taps
+    inline constexpr static int CUBE_FACE_COUNT = 6;
+    inline constexpr static float CUBE_FACE_FOV = 95.0f;
 
     bool project_shadows = true;
 
 private:
     glm::mat4 view_matrix = glm::mat4(1.0f);
     glm::mat4 projection_matrix = glm::mat4(1.0f);
+    glm::mat4 view_projection_matrix = glm::mat4(1.0f); // cached product of the two above
 
     glm::vec3 target = glm::vec3(0.0f);
     glm::vec3 position = glm::vec3(0.0f);
@@ -29,19 +60,57 @@ private:
     glm::vec3 light_right;
     glm::vec3 light_forward;
 
+    Mode mode = Mode::POINT;
+    int cascade_count = 3;
+    int shadow_map_size = DEFAULT_SHADOW_MAP_SIZE;
+
+    Bounds shadow_bounds; // of the shadow casters & receivers, every shadow map is fitted to it
+
+    std::array<glm::mat4, MAX_CASCADES> cascade_view_projections{};
+    std::array<float, MAX_CASCADES> cascade_depth_biases{}; // in each cascade's own depth range
+
+    std::array<glm::mat4, CUBE_FACE_COUNT> cube_face_view_projections{};
+
+    // near over far plane of the perspective projections, which linearizes their depths (see GetShadowDepthRatio)
+    float projection_depth_ratio = NEAR_PLANE / FAR_PLANE;
+    float cube_face_depth_ratio = NEAR_PLANE / FAR_PLANE;
+
+    bool shadow_dirty = true; // whether the shadow maps' views changed since they were last rendered
+
 public:
     Light() = default;
     Light(glm::vec3 _position, glm::vec3 _color, float _ambientStrength, float _specularStrength);
 
     void SetPosition(const glm::vec3& _position);
     void SetTarget(const glm::vec3& _target);
+    void SetMode(Mode _mode);
+    void SetCascadeCount(int _count); // clamped to [MIN_CASCADES, MAX_CASCADES], only used in sun mode
+    void SetShadowMapSize(int _size); // clamped to [MIN_SHADOW_MAP_SIZE, MAX_SHADOW_MAP_SIZE]
+    void FitShadowBounds(const Bounds &_bounds); // refits the shadow maps to the given bounds, if they changed enough
+
+    void UpdateCascades(const Camera &_camera); // refits the sun's cascades to the camera's frustum, to be called every frame in sun mode
 
     [[nodiscard]] glm::vec3 GetPosition() const;
     [[nodiscard]] glm::vec3 GetTarget() const;
     [[nodiscard]] glm::vec3 GetColor() const;
-    [[nodiscard]] glm::mat4 GetViewProjection() const;
+    [[nodiscard]] const glm::mat4& GetViewProjection() const;
+    [[nodiscard]] Mode GetMode() const { return mode; }
+    [[nodiscard]] int GetCascadeCount() const { return cascade_count; }
+
+    // Shadow maps to render & sample: a single one in perspective mode, one per cascade in sun mode, one per cube face in point mode
+    [[nodiscard]] int GetShadowMapCount() const { return mode == Mode::SUN ? cascade_count : mode == Mode::POINT ? CUBE_FACE_COUNT : 1; }
+    [[nodiscard]] int GetShadowMapSize() const { return mode == Mode::PERSPECTIVE ? shadow_map_size : shadow_map_size / 2; }
+    [[nodiscard]] int GetBaseShadowMapSize() const { return shadow_map_size; } // as set, regardless of the mode
+    [[nodiscard]] const glm::mat4& GetShadowViewProjection(int _index) const;
+    [[nodiscard]] float GetShadowDepthBias(int _index) const;
+    [[nodiscard]] float GetShadowDepthRatio(int _index) const; // near over far plane of a shadow map's projection, 1 for the sun's orthographic ones
+
+    [[nodiscard]] bool IsShadowDirty() const { return shadow_dirty; }
+    void ClearShadowDirty() { shadow_dirty = false; } // to be called once the shadow maps were rendered with the current views
 
 private:
-    void UpdateView(); //for when the camera's rotation changes
-    void UpdateProjection(); //for when the camera's viewport changes (mainly)
+    void UpdateView(); //for when the light's position or target changes (also refits the projection)
+    void UpdateProjection(); //for when the shadow bounds change
+    void UpdateCubeFaces(); //for when the light's position or the shadow bounds change
+    void UpdateViewProjection(); //for when either of the above changes
 };
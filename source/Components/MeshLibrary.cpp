@@ -0,0 +1,27 @@
+#include "MeshLibrary.h"
+
+#include <iostream>
+
+std::map<MeshLibrary::Key, std::shared_ptr<const Mesh>> MeshLibrary::meshes;
+
+std::shared_ptr<const Mesh> MeshLibrary::Find(const MeshLibrary::Key &_key) {
+    const auto mesh_it = meshes.find(_key);
+
+    if (mesh_it == meshes.end())
+        return nullptr;
+
+    ++shared_count;
+    return mesh_it->second;
+}
+
+std::shared_ptr<const Mesh> MeshLibrary::Add(const MeshLibrary::Key &_key, Mesh &&_mesh) {
+    // the first mesh interned under a key wins, so that every object keeps sharing the same buffers
+    auto [mesh_it, inserted] = meshes.try_emplace(_key, nullptr);
+
+    if (inserted)
+        mesh_it->second = std::make_shared<const Mesh>(std::move(_mesh));
+    else
+        std::cout << "ERROR::MESH_LIBRARY::KEY_ALREADY_INTERNED" << std::endl;
+
+    return mesh_it->second;
+}
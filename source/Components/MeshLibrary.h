@@ -0,0 +1,73 @@
+// Interns geometry, so that objects built from the same shape & parameters share one set of GPU buffers (and are only built once)
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+#include "glad/glad.h"
+#include "Utility/Bounds.hpp"
+
+// Geometry shared between objects, never modified once it is interned
+struct Mesh {
+public:
+    // Part of the buffers drawn as one level of detail, its indices being relative to its first vertex
+    struct Lod {
+    public:
+        GLsizei index_offset = 0;
+        GLsizei index_count = 0;
+        GLint base_vertex = 0;
+    };
+
+    std::vector<float> vertices; // interleaved attributes, vertex_stride floats per vertex
+    std::vector<int> indices; // empty when the mesh is drawn without indices
+    std::vector<Lod> lods; // coarsest first, empty unless the buffers hold a chain of levels of detail
+
+    int vertex_stride = 0;
+
+    Bounds bounds; // in the mesh's own space
+    BoundingSphere sphere;
+
+    GLuint vertex_array_o = 0;
+    GLuint depth_vertex_array_o = 0; // positions only, for depth-only passes
+
+    // per-instance transforms & colors, only created once the mesh is drawn instanced
+    // it isn't geometry, and its content is replaced on every instanced draw anyway
+    mutable GLuint instance_buffer_o = 0;
+
+    [[nodiscard]] GLsizei VertexCount() const { return (GLsizei)(vertices.size() / vertex_stride); }
+    [[nodiscard]] GLsizei IndexCount() const { return (GLsizei)indices.size(); }
+};
+
+class MeshLibrary {
+public:
+    enum class Shape : uint8_t {
+        CUBE,
+        SPHERE,
+    };
+
+    // Identifies a mesh by the parameters it was built from (e.g. a cube's transform offset, or a sphere's radius)
+    struct Key {
+    public:
+        Shape shape;
+        std::array<float, 4> parameters{};
+
+        auto operator<=>(const Key &_other) const = default;
+    };
+
+private:
+    static std::map<Key, std::shared_ptr<const Mesh>> meshes;
+
+public:
+    inline static int shared_count = 0; // number of times an already interned mesh was handed out (for profiling purposes)
+
+public:
+    MeshLibrary() = delete;
+
+    [[nodiscard]] static std::shared_ptr<const Mesh> Find(const Key &_key); // nullptr if nothing was interned under this key yet
+    static std::shared_ptr<const Mesh> Add(const Key &_key, Mesh &&_mesh);
+
+    [[nodiscard]] static size_t Count() { return meshes.size(); }
+};
@@ -0,0 +1,288 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+void RenderQueue::Clear() {
+    packets.clear();
+    sort_entries.clear();
+
+    instance_transforms.clear();
+    instance_colors.clear();
+
+    pass_bounds.fill(Bounds());
+
+    stats = {};
+    current_condition_query = 0;
+    sorted = true;
+}
+
+void RenderQueue::SetPass(RenderQueue::Pass _pass, const glm::vec3 &_eyePosition, float _maxDepth) {
+    current_pass = _pass;
+    current_eye_position = _eyePosition;
+    current_max_depth = _maxDepth;
+}
+
+void RenderQueue::SetCondition(GLuint _query) {
+    current_condition_query = _query;
+}
+
+void RenderQueue::Push(VisualObject *_object, const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material, Layer _layer) {
+    const Shader::Material *current_material = _material != nullptr ? _material : &_object->material;
+
+    // translucency is a property of the material, so it overrides whatever layer was asked for
+    if (current_material->alpha < 1.0f)
+        _layer = Layer::TRANSLUCENT;
+
+    const uint64_t key = MakeKey(*current_material, current_material->shader->program_id, GetVertexArray(_object, IsShadowPass(current_pass)), glm::vec3(_transformMatrix[3]), _layer);
+
+    const Bounds bounds = _object->GetLocalBounds().Transformed(_transformMatrix);
+
+    pass_bounds[(size_t)current_pass].Add(bounds);
+
+    AddPacket({
+        .object = _object,
+        .material = current_material,
+        .transform = _transformMatrix,
+        .render_mode = _renderMode,
+        .bounds = bounds,
+        .sphere = _object->GetLocalSphere().Transformed(_transformMatrix),
+        .condition_query = current_condition_query,
+    }, key);
+}
+
+void RenderQueue::PushInstanced(VisualObject *_object, std::span<const glm::mat4> _transformMatrices, std::span<const glm::vec3> _colors, int _renderMode, const Shader::Material *_material) {
+    if (_transformMatrices.empty())
+        return;
+
+    const Shader::Material *current_material = _material != nullptr ? _material : &_object->material;
+    const auto &instanced_shader = current_material->shader->instanced_variant;
+
+    // the instances are copied, so that the caller's storage doesn't have to outlive the queue
+    const auto instance_offset = (uint32_t)instance_transforms.size();
+
+    instance_transforms.insert(instance_transforms.end(), _transformMatrices.begin(), _transformMatrices.end());
+
+    if (_colors.size() == _transformMatrices.size())
+        instance_colors.insert(instance_colors.end(), _colors.begin(), _colors.end());
+    else
+        instance_colors.insert(instance_colors.end(), _transformMatrices.size(), current_material->color);
+
+    const Layer layer = current_material->alpha < 1.0f ? Layer::TRANSLUCENT : Layer::OPAQUE;
+    const GLuint program_id = instanced_shader != nullptr ? instanced_shader->program_id : current_material->shader->program_id;
+
+    // instances are sorted as a whole, by the first one's position
+    // their attributes only live in the full vertex array, which depth-only draws of them use as well
+    const uint64_t key = MakeKey(*current_material, program_id, GetVertexArray(_object, false), glm::vec3(_transformMatrices.front()[3]), layer);
+
+    Bounds bounds;
+
+    for (const auto &transform_matrix : _transformMatrices)
+        bounds.Add(_object->GetLocalBounds().Transformed(transform_matrix));
+
+    pass_bounds[(size_t)current_pass].Add(bounds);
+
+    AddPacket({
+        .object = _object,
+        .material = current_material,
+        .transform = _transformMatrices.front(),
+        .render_mode = _renderMode,
+        .bounds = bounds,
+        .sphere = BoundingSphere::Around(bounds),
+        .condition_query = current_condition_query,
+        .instance_offset = instance_offset,
+        .instance_count = (uint32_t)_transformMatrices.size(),
+    }, key);
+}
+
+void RenderQueue::PushBounds(const Bounds &_worldBounds) {
+    pass_bounds[(size_t)current_pass].Add(_worldBounds);
+}
+
+int RenderQueue::Cull(RenderQueue::Pass _pass, std::span<const Frustum> _frustums) {
+    const auto is_in_pass = [_pass](const SortEntry &_entry) { return (Pass)(_entry.key >> 62) == _pass; };
+
+    // the pass' packets are all tested at once, in the order of their sort entries
+    culler.Clear();
+
+    for (const auto &entry : sort_entries) {
+        if (!is_in_pass(entry))
+            continue;
+
+        const Packet &packet = packets[entry.packet_index];
+        culler.Add(packet.bounds, packet.sphere);
+    }
+
+    culler.Test(_frustums);
+
+    // packets stay in storage, only their sort entries are dropped, so that nothing refers to them anymore
+    size_t tested_index = 0;
+
+    const auto culled_count = std::erase_if(sort_entries, [&](const SortEntry &_entry) {
+        return is_in_pass(_entry) && !culler.IsVisible(tested_index++);
+    });
+
+    stats.culled_packets += (int)culled_count;
+
+    return (int)culled_count;
+}
+
+int RenderQueue::GetPacketCount(RenderQueue::Pass _pass) const {
+    return (int)std::count_if(sort_entries.begin(), sort_entries.end(), [_pass](const SortEntry &_entry) { return (Pass)(_entry.key >> 62) == _pass; });
+}
+
+void RenderQueue::Sort() {
+    const size_t count = sort_entries.size();
+
+    sort_scratch.resize(count);
+
+    // 8 passes of 8 bits each, from the least to the most significant byte (stable, so each pass keeps the previous' order)
+    for (int shift = 0; shift < 64 && count > 1; shift += 8) {
+        std::array<uint32_t, 256> histogram{};
+
+        for (const auto &entry : sort_entries)
+            ++histogram[(entry.key >> shift) & 0xFF];
+
+        // if every key has the same byte here, this pass wouldn't change anything
+        if (histogram[(sort_entries[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        // turns the histogram into each byte value's starting offset
+        uint32_t offset = 0;
+        for (auto &bucket : histogram) {
+            const uint32_t bucket_count = bucket;
+
+            bucket = offset;
+            offset += bucket_count;
+        }
+
+        for (const auto &entry : sort_entries)
+            sort_scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+
+        std::swap(sort_entries, sort_scratch);
+    }
+
+    sorted = true;
+}
+
+void RenderQueue::Submit(RenderQueue::Pass _pass, RenderQueue::Layer _firstLayer, RenderQueue::Layer _lastLayer) {
+    // the shadow passes only need depth, so they go through the position-only path with each packet's own (depth) material
+    SubmitRange(_pass, _firstLayer, _lastLayer, IsShadowPass(_pass), nullptr);
+}
+
+void RenderQueue::SubmitDepth(RenderQueue::Pass _pass, RenderQueue::Layer _firstLayer, RenderQueue::Layer _lastLayer, const Shader::Material &_depthMaterial) {
+    SubmitRange(_pass, _firstLayer, _lastLayer, true, &_depthMaterial);
+}
+
+void RenderQueue::SubmitInside(RenderQueue::Pass _pass, const Frustum &_frustum) {
+    SubmitRange(_pass, Layer::OPAQUE, Layer::TRANSLUCENT, IsShadowPass(_pass), nullptr, std::span(&_frustum, 1));
+}
+
+void RenderQueue::SubmitRange(RenderQueue::Pass _pass, RenderQueue::Layer _firstLayer, RenderQueue::Layer _lastLayer, bool _depthOnly, const Shader::Material *_depthMaterial, std::span<const Frustum> _frustums) {
+    if (!sorted)
+        Sort();
+
+    // the pass & layer are in the key's top bits, so a range of layers of a pass is contiguous once sorted
+    const auto pass_and_layer_of = [](const SortEntry &_entry) { return (uint8_t)(_entry.key >> 60); };
+    const auto first = (uint8_t)(((uint8_t)_pass << 2) | (uint8_t)_firstLayer);
+    const auto last = (uint8_t)(((uint8_t)_pass << 2) | (uint8_t)_lastLayer);
+
+    const auto range_begin = std::partition_point(sort_entries.begin(), sort_entries.end(), [&](const SortEntry &_entry) { return pass_and_layer_of(_entry) < first; });
+    const auto range_end = std::partition_point(range_begin, sort_entries.end(), [&](const SortEntry &_entry) { return pass_and_layer_of(_entry) <= last; });
+
+    // the range is tested as a whole, its packets staying in the queue whatever the result
+    const bool restricted = !_frustums.empty();
+
+    if (restricted) {
+        culler.Clear();
+
+        for (auto it = range_begin; it != range_end; ++it)
+            culler.Add(packets[it->packet_index].bounds, packets[it->packet_index].sphere);
+
+        culler.Test(_frustums);
+    }
+
+    const Packet *previous_packet = nullptr;
+
+    for (auto it = range_begin; it != range_end; ++it) {
+        const Packet &packet = packets[it->packet_index];
+
+        if (restricted && !culler.IsVisible((size_t)(it - range_begin))) {
+            ++stats.skipped_packets;
+            continue;
+        }
+
+        if (previous_packet == nullptr || previous_packet->material->shader != packet.material->shader)
+            ++stats.program_changes;
+        if (previous_packet == nullptr || previous_packet->material->texture != packet.material->texture)
+            ++stats.texture_changes;
+        if (previous_packet == nullptr || GetVertexArray(previous_packet->object, _depthOnly) != GetVertexArray(packet.object, _depthOnly))
+            ++stats.vertex_array_changes;
+
+        // without waiting on the query: if its result isn't there yet, the packet is drawn anyway
+        if (packet.condition_query != 0) {
+            glBeginConditionalRender(packet.condition_query, GL_QUERY_NO_WAIT);
+            ++stats.conditional_draws;
+        }
+
+        if (_depthOnly) {
+            const Shader::Material &depth_material = _depthMaterial != nullptr ? *_depthMaterial : *packet.material;
+
+            if (packet.instance_count > 0 && depth_material.shader->instanced_variant != nullptr) {
+                packet.object->DrawInstanced(std::span(instance_transforms).subspan(packet.instance_offset, packet.instance_count), {}, packet.render_mode, &depth_material);
+            } else if (packet.instance_count > 0) {
+                for (uint32_t i = 0; i < packet.instance_count; ++i)
+                    packet.object->DrawDepth(instance_transforms[packet.instance_offset + i], packet.render_mode, depth_material);
+            } else {
+                packet.object->DrawDepth(packet.transform, packet.render_mode, depth_material);
+            }
+        } else if (packet.instance_count > 0) {
+            packet.object->DrawInstanced(std::span(instance_transforms).subspan(packet.instance_offset, packet.instance_count),
+                                         std::span(instance_colors).subspan(packet.instance_offset, packet.instance_count),
+                                         packet.render_mode, packet.material);
+        } else {
+            packet.object->DrawFromMatrix(packet.transform, packet.render_mode, packet.material);
+        }
+
+        if (packet.condition_query != 0)
+            glEndConditionalRender();
+
+        previous_packet = &packet;
+    }
+}
+
+uint64_t RenderQueue::MakeKey(const Shader::Material &_material, GLuint _programId, GLuint _vertexArray, const glm::vec3 &_position, RenderQueue::Layer _layer) {
+    // unseen materials get the next id, which wraps around if there are ever more than 4096 of them (only hurts grouping, not correctness)
+    auto material_it = material_ids.try_emplace(&_material, (uint16_t)material_ids.size()).first;
+
+    const uint64_t program = _programId & 0xFF;
+    const uint64_t texture = _material.texture & 0xFF;
+    const uint64_t vertex_array = _vertexArray & 0xFF;
+    const uint64_t material = material_it->second & 0xFFF;
+
+    // distance to the eye, quantized over the whole depth range of the pass
+    const float normalized_depth = std::clamp(glm::length(_position - current_eye_position) / current_max_depth, 0.0f, 1.0f);
+    const auto depth = (uint64_t)(normalized_depth * (float)DEPTH_MAX);
+
+    const uint64_t state = (program << 28) | (texture << 20) | (vertex_array << 12) | material;
+
+    uint64_t key = ((uint64_t)current_pass << 62) | ((uint64_t)_layer << 60);
+
+    if (_layer == Layer::TRANSLUCENT)
+        key |= ((DEPTH_MAX - depth) << 36) | state;
+    else
+        key |= (state << DEPTH_BITS) | depth;
+
+    return key;
+}
+
+GLuint RenderQueue::GetVertexArray(const VisualObject *_object, bool _depthOnly) {
+    return _depthOnly ? _object->GetDepthVertexArray() : _object->GetVertexArray();
+}
+
+void RenderQueue::AddPacket(const RenderQueue::Packet &_packet, uint64_t _key) {
+    sort_entries.push_back({_key, (uint32_t)packets.size()});
+    packets.push_back(_packet);
+
+    ++stats.packets;
+    sorted = false;
+}
@@ -0,0 +1,129 @@
+// Collects every draw of a frame as a packet, sorts them by a packed 64-bit key and submits them in one loop
+// Sorting keeps identical programs, textures & vertex arrays together, and orders fragments so that depth testing rejects as much as possible
+
+#pragma once
+
+#include <array>
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "Shader.h"
+#include "Visual/VisualObject.h"
+#include "Utility/Bounds.hpp"
+#include "Utility/Frustum.hpp"
+#include "Utility/FrustumCuller.hpp"
+
+class RenderQueue {
+public:
+    enum class Pass : uint8_t {
+        STATIC_SHADOW = 0, // casters that never move, only re-rendered when the light does
+        DYNAMIC_SHADOW = 1, // moving casters, re-rendered whenever they move
+        COLOR = 2,
+        ATLAS_SHADOW = 3, // every caster, drawn into the point lights' shadow atlas tiles (see ShadowAtlas)
+    };
+
+    // Order in which packets of a same pass are drawn
+    enum class Layer : uint8_t {
+        OPAQUE = 0, // front-to-back, grouped by state
+        BACKGROUND = 1, // drawn after every opaque object, so that most of it is rejected by depth testing (e.g. the sky)
+        TRANSLUCENT = 2, // back-to-front, so that blending is correct
+    };
+
+    struct Packet {
+    public:
+        VisualObject *object;
+        const Shader::Material *material;
+        glm::mat4 transform;
+        int render_mode;
+        Bounds bounds; // in world space, of every instance for instanced packets
+        BoundingSphere sphere;
+
+        // occlusion query the packet is drawn under conditional rendering of (skipped by the GPU if it found no sample), 0 to always draw it
+        GLuint condition_query = 0;
+
+        // only used by instanced packets, which index the queue's instance storage
+        uint32_t instance_offset = 0;
+        uint32_t instance_count = 0;
+    };
+
+    // Per-frame counters (for profiling purposes)
+    struct Stats {
+    public:
+        int packets = 0;
+        int program_changes = 0;
+        int texture_changes = 0;
+        int vertex_array_changes = 0;
+        int culled_packets = 0;
+        int skipped_packets = 0; // outside of the frustum a submit was restricted to, but kept for other submits of their pass
+        int conditional_draws = 0;
+    };
+
+private:
+    // key layout, from the most significant bit: pass (2) | layer (2) | 60 bits that depend on the layer
+    //   opaque & background: program (8) | texture (8) | vertex array (8) | material (12) | depth (24)
+    //   translucent:         inverted depth (24) | program (8) | texture (8) | vertex array (8) | material (12)
+    inline constexpr static int DEPTH_BITS = 24;
+    inline constexpr static uint64_t DEPTH_MAX = (1ull << DEPTH_BITS) - 1;
+
+    struct SortEntry {
+        uint64_t key;
+        uint32_t packet_index;
+    };
+
+    std::vector<Packet> packets;
+    std::vector<SortEntry> sort_entries;
+    std::vector<SortEntry> sort_scratch;
+
+    FrustumCuller culler; // bounds of the packets being culled, tested in batches
+
+    std::vector<glm::mat4> instance_transforms;
+    std::vector<glm::vec3> instance_colors;
+
+    // world bounds of every packet of each pass
+    std::array<Bounds, 4> pass_bounds;
+
+    // materials are given small ids in the order they are first seen, so that they fit in the key
+    std::unordered_map<const Shader::Material *, uint16_t> material_ids;
+
+    Pass current_pass = Pass::COLOR;
+    GLuint current_condition_query = 0;
+    glm::vec3 current_eye_position = glm::vec3(0.0f);
+    float current_max_depth = 1.0f;
+
+    bool sorted = true;
+
+public:
+    Stats stats;
+
+public:
+    RenderQueue() = default;
+
+    void Clear(); // drops every packet, to be called at the start of a frame
+    void SetPass(Pass _pass, const glm::vec3 &_eyePosition, float _maxDepth); // every following push is recorded for this pass, sorted by distance to this eye
+    void SetCondition(GLuint _query); // every following push is only drawn if this occlusion query found samples (0 for unconditional draws)
+
+    void Push(VisualObject *_object, const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material = nullptr, Layer _layer = Layer::OPAQUE);
+    void PushInstanced(VisualObject *_object, std::span<const glm::mat4> _transformMatrices, std::span<const glm::vec3> _colors, int _renderMode, const Shader::Material *_material = nullptr);
+    void PushBounds(const Bounds &_worldBounds); // grows the current pass' bounds without drawing anything (e.g. with a shadow receiver that doesn't cast)
+
+    int Cull(Pass _pass, std::span<const Frustum> _frustums); // drops the packets of a pass that are outside of every frustum, returns how many were
+
+    [[nodiscard]] const Bounds &GetBounds(Pass _pass) const { return pass_bounds[(size_t)_pass]; }
+    [[nodiscard]] int GetPacketCount(Pass _pass) const; // packets of a pass that are still to be drawn (i.e. weren't culled)
+    [[nodiscard]] static bool IsShadowPass(Pass _pass) { return _pass != Pass::COLOR; }
+
+    void Sort(); // LSD radix sort of the packets' keys
+    void Submit(Pass _pass, Layer _firstLayer = Layer::OPAQUE, Layer _lastLayer = Layer::TRANSLUCENT); // draws every packet of a pass' layers, in key order
+    void SubmitDepth(Pass _pass, Layer _firstLayer, Layer _lastLayer, const Shader::Material &_depthMaterial); // same, but only their depth (e.g. for a depth prepass)
+    void SubmitInside(Pass _pass, const Frustum &_frustum); // same as Submit, but skips the packets outside of the frustum without dropping them (e.g. for one of several views sharing a pass)
+
+private:
+    [[nodiscard]] uint64_t MakeKey(const Shader::Material &_material, GLuint _programId, GLuint _vertexArray, const glm::vec3 &_position, Layer _layer);
+    void SubmitRange(Pass _pass, Layer _firstLayer, Layer _lastLayer, bool _depthOnly, const Shader::Material *_depthMaterial, std::span<const Frustum> _frustums = {}); // only the packets inside of the frusta, unless there are none
+
+    [[nodiscard]] static GLuint GetVertexArray(const VisualObject *_object, bool _depthOnly); // the vertex array an object is drawn with
+    void AddPacket(const Packet &_packet, uint64_t _key);
+};
@@ -1,4 +1,7 @@
 #include "Renderer.h"
+
+#include <chrono>
+#include <random>
 #include "Utility/Input.hpp"
 #include "Utility/Transform.hpp"
 
@@ -16,18 +19,80 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
 
     auto grid_shader = Shader::Library::CreateShader("shaders/grid/grid.vert", "shaders/grid/grid.frag");
     auto unlit_shader = Shader::Library::CreateShader("shaders/unlit/unlit.vert", "shaders/unlit/unlit.frag");
-    auto lit_shader = Shader::Library::CreateShader("shaders/lit/lit.vert", "shaders/lit/lit.frag");
 
-    auto shadow_mapper_shader = Shader::Library::CreateShader("shaders/shadows/shadow_mapper.vert", "shaders/shadows/shadow_mapper.frag");
+    const auto create_lit_variant = [](const std::string &_defines) {
+        auto variant = Shader::Library::CreateShader("shaders/lit/lit.vert", "shaders/lit/lit.frag", _defines);
+        variant->instanced_variant = Shader::Library::CreateShader("shaders/lit/lit_instanced.vert", "shaders/lit/lit.frag", _defines);
+
+        // texture units never change, so they are assigned once instead of on every draw
+        for (const auto &program : {variant, variant->instanced_variant}) {
+            program->SetTexture("u_depth_texture", 0);
+            program->SetTexture("u_texture", 1);
+            program->SetTexture("u_point_lights", ClusteredLights::POINT_LIGHTS_UNIT);
+            program->SetTexture("u_light_grid", ClusteredLights::LIGHT_GRID_UNIT);
+            program->SetTexture("u_light_indices", ClusteredLights::LIGHT_INDICES_UNIT);
+            program->SetTexture("u_exponential_shadows", EXPONENTIAL_SHADOWS_UNIT);
+            program->SetTexture("u_shadow_atlas", ShadowAtlas::ATLAS_UNIT);
+            program->SetTexture("u_shadow_tiles", ShadowAtlas::TILES_UNIT);
+        }
+
+        return variant;
+    };
+
+    // one lit variant per shadow filter, they only differ by their number of shadow map taps
+    for (size_t i = 0; i < SHADOW_FILTER_TAPS.size(); ++i)
+        lit_shadow_filter_variants[i] = create_lit_variant("#define SHADOW_TAPS " + std::to_string(SHADOW_FILTER_TAPS[i]));
+
+    lit_exponential_variant = create_lit_variant("#define SHADOW_ESM 1");
+
+    lit_shader = std::make_shared<Shader>(*lit_shadow_filter_variants[shadow_filter]);
+
+    const std::array<std::pair<int, std::string>, 3> shadow_mapper_primitives = {{{GL_TRIANGLES, ""}, {GL_LINES, "#define SHADOW_LINES"}, {GL_POINTS, "#define SHADOW_POINTS"}}};
+
+    for (const auto &[render_mode, defines] : shadow_mapper_primitives) {
+        auto shadow_mapper_shader = Shader::Library::CreateShader("shaders/shadows/shadow_mapper.vert", "shaders/shadows/shadow_mapper.geom", "shaders/shadows/shadow_mapper.frag", defines);
+        shadow_mapper_shader->instanced_variant = Shader::Library::CreateShader("shaders/shadows/shadow_mapper_instanced.vert", "shaders/shadows/shadow_mapper.geom", "shaders/shadows/shadow_mapper.frag", defines);
+
+        shadow_mapper_materials[render_mode].shader = shadow_mapper_shader;
+    }
+
+    auto depth_prepass_shader = Shader::Library::CreateShader("shaders/depth/depth_prepass.vert", "shaders/depth/depth_prepass.frag");
+    depth_prepass_shader->instanced_variant = Shader::Library::CreateShader("shaders/depth/depth_prepass_instanced.vert", "shaders/depth/depth_prepass.frag");
     auto screen_shader = Shader::Library::CreateShader("shaders/screen/screen.vert", "shaders/screen/screen.frag");
 
-    shadow_mapper_material = std::make_unique<Shader::Material>();
-    shadow_mapper_material->shader = shadow_mapper_shader;
+    // both blur passes draw the screen quad
+    exponential_horizontal_blur_material.shader = Shader::Library::CreateShader("shaders/screen/screen.vert", "shaders/screen/exponential_blur.frag", "#define ESM_HORIZONTAL 1");
+    exponential_horizontal_blur_material.shader->SetTexture("u_depth_texture", 0);
+
+    exponential_vertical_blur_material.shader = Shader::Library::CreateShader("shaders/screen/screen.vert", "shaders/screen/exponential_blur.frag", "#define ESM_HORIZONTAL 0");
+    exponential_vertical_blur_material.shader->SetTexture("u_texture", 1);
+
+    depth_prepass_material = std::make_unique<Shader::Material>();
+    depth_prepass_material->shader = depth_prepass_shader;
+
+    // drawn in the rackets' bounds by their occlusion queries, depth only
+    occlusion_box = std::make_unique<VisualCube>(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.0f), *depth_prepass_material);
+
+    // camera & light uniforms shared by all programs, uploaded once per pass
+    frame_uniforms = std::make_unique<FrameUniforms>();
+
+    // every draw of a frame goes through the queue, so that it can be sorted before being submitted
+    render_queue = std::make_unique<RenderQueue>();
+
+    clustered_lights = std::make_unique<ClusteredLights>();
+    SetPointLightCount(POINT_LIGHT_COUNTS[1]);
+
+    shadow_atlas = std::make_unique<ShadowAtlas>();
+    shadow_atlas->update_budget = SHADOW_ATLAS_BUDGETS[1];
+
+    color_pass_time_query = std::make_unique<GLQuery>(GL_TIME_ELAPSED);
+    color_pass_samples_query = std::make_unique<GLQuery>(GL_SAMPLES_PASSED);
+
+    screen_shader->SetTexture("u_texture", 0);
 
     Shader::Material main_light_cube_material = {
         .shader = unlit_shader,
         .color = main_light->GetColor(),
-        .main_light = main_light,
     };
     main_light_cube = std::make_unique<VisualCube>(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.0f), main_light_cube_material);
 
@@ -40,7 +105,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     Shader::Material default_s_material = {
         .shader = lit_shader,
         .color = glm::vec3(1.0f),
-        .main_light = main_light,
     };
 
     // grid
@@ -83,10 +147,10 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
 
     Shader::Material world_t_material = {
         .shader = lit_shader,
-        .main_light = main_light,
         .texture = LoadTexture("assets/clay_texture.jpg"),
         .texture_influence = 1.0f,
         .shininess = 1,
+        .casts_shadows = false, // flat on the floor, it can only shadow what is below it
     };
 
     ground_plane = std::make_unique<VisualPlane>(glm::vec3(0.0f, -0.1f, 0.0f), glm::vec3(0.0f), glm::vec3(42.0f, 20.0f, 20.0f), world_t_material);
@@ -95,7 +159,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     
     Shader::Material world_tennisfuzz_material = {
         .shader = lit_shader,
-        .main_light = main_light,
         .texture = LoadTexture("assets/fuzz.jpg"),
         .texture_influence = 1.0f,
         .shininess = 1,
@@ -114,7 +177,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     Shader::Material netpost_s_material = {
         .shader = lit_shader,
         .color = glm::vec3(0.51f, 0.53f, 0.53f),
-        .main_light = main_light,
         .shininess = 4,
     };
     net_cubes[0] = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, netpost_s_material); // net post
@@ -122,7 +184,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     Shader::Material net_s_material = {
         .shader = lit_shader,
         .color = glm::vec3(0.96f, 0.96f, 0.96f),
-        .main_light = main_light,
         .shininess = 128,
     };
     net_cubes[1] = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, net_s_material); // net
@@ -133,22 +194,22 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
     Shader::Material a_s_material = {
         .shader = lit_shader,
         .color = glm::vec3(0.15f, 0.92f, 0.17f),
-        .main_light = main_light,
         .shininess = 4,
     };
     letter_cubes[0] = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, a_s_material); // letter a
 
     letter_cubes[1] = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, default_s_material); // letter g
+    letter_cubes[1].material.color = glm::vec3(1.0f, 0.714f, 0.757f); // pink colour
 
     letter_cubes[2] = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, default_s_material); // letter j
 
     Shader::Material j_s_material = {
         .shader = lit_shader,
         .color = glm::vec3(0.34f, 0.84f, 0.98f),
-        .main_light = main_light,
         .shininess = 128,
     };
     letter_cubes[2] = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, j_s_material); // letter j
+    letter_cubes[2].material.color = glm::vec3(1.0f, 0.714f, 0.757f); // pink colour
 
     const auto racket_line_thickness = 2.0f;
     const auto racket_point_size = 3.0f;
@@ -165,7 +226,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
         .line_thickness = racket_line_thickness,
         .point_size = racket_point_size,
         .color = glm::vec3(0.58f, 0.38f, 0.24f),
-        .main_light = main_light,
         .shininess = 2,
     }); // skin
 
@@ -174,7 +234,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
         .line_thickness = racket_line_thickness,
         .point_size = racket_point_size,
         .color = glm::vec3(0.2f),
-        .main_light = main_light,
         .shininess = 64,
     }); // racket handle (black plastic)
 
@@ -183,7 +242,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
         .line_thickness = racket_line_thickness,
         .point_size = racket_point_size,
         .color = glm::vec3(0.1f, 0.2f, 0.9f),
-        .main_light = main_light,
         .shininess = 64,
     }); // racket piece (blue plastic)
 
@@ -192,7 +250,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
         .line_thickness = racket_line_thickness,
         .point_size = racket_point_size,
         .color = glm::vec3(0.1f, 0.9f, 0.2f),
-        .main_light = main_light,
         .shininess = 64,
     }); // racket piece (green plastic)
 
@@ -202,7 +259,6 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
         .point_size = racket_point_size,
         .color = glm::vec3(0.94f),
         .alpha = 0.95f,
-        .main_light = main_light,
         .shininess = 64,
     }); // racket net (white plastic)
 
@@ -216,6 +272,11 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
 
     // gabrielle racket cube
     gabrielle_racket_cube = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, default_s_material);
+    gabrielle_racket_materials = std::vector<Shader::Material>(3, default_s_material);
+    gabrielle_racket_materials[0].color = glm::vec3(0.871f, 0.722f, 0.529f); // skin colour
+    gabrielle_racket_materials[1].color = glm::vec3(1.0f, 0.714f, 0.757f); // pink colour
+    gabrielle_racket_materials[2].color = glm::vec3(1.0f, 1.0f, 1.0f); // white net colour
+
     rackets[1] = default_rackets[1] = Racket(
         glm::vec3(10.0f, 0.0f, 0.0f),
         glm::vec3(0.0f),
@@ -225,39 +286,78 @@ Renderer::Renderer(int _initialWidth, int _initialHeight)
 
     // jack racket cube
     jack_racket_cube = VisualCube(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), bottom_y_transform_offset, default_s_material);
+    jack_racket_materials = std::vector<Shader::Material>(3, default_s_material);
+    jack_racket_materials[0].color = glm::vec3(1.000f, 0.894f, 0.769f); // skin colour
+    jack_racket_materials[1].color = glm::vec3(0.0f, 0.5f, 0.5f); // teal colour
+    jack_racket_materials[2].color = glm::vec3(1.0f, 1.0f, 1.0f); // white net colour
+
     rackets[2] = default_rackets[2] = Racket(
         glm::vec3(-10.0f, 0.0f, 0.0f),
         glm::vec3(0.0f),
         glm::vec3(0.8f));
     //
+
+    BakeNet();
+
+    // racket hierarchies only have to be walked once, their parts' transforms never change
+    racket_rigs = std::vector<RacketRig>(3);
+    BuildAugustoRacketRig(racket_rigs[0]);
+    BuildGabrielleRacketRig(racket_rigs[1]);
+    BuildJackRacketRig(racket_rigs[2]);
+
+    BuildScene();
+
+    std::cout << "INFO -> Mesh library: " << MeshLibrary::Count() << " meshes, shared " << MeshLibrary::shared_count << " times" << std::endl;
 }
 
 void Renderer::Init() {
     // initializes the shadow map framebuffer
     glGenFramebuffers(1, &shadow_map_fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, shadow_map_fbo);
-
-    // cleanup the texture bind
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLStateCache::BindFramebuffer(shadow_map_fbo);
 
-    // initializes the shadow map depth texture
+    // initializes the shadow map depth texture, an array so that every cascade of the sun fits in it
     glGenTextures(1, &shadow_map_depth_tex);
-    glBindTexture(GL_TEXTURE_2D, shadow_map_depth_tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, Light::LIGHTMAP_SIZE, Light::LIGHTMAP_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, shadow_map_depth_tex);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    // compared by the hardware when sampled, which also filters 2x2 comparisons for free with linear filtering
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 
     float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
     glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-    // binds the shadow map depth texture to the framebuffer
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadow_map_depth_tex, 0);
+    // the exponential maps are linearly filtered when sampled, the blur only fetching exact texels
+    glGenTextures(1, &exponential_shadows_tex);
+    GLStateCache::BindTexture(EXPONENTIAL_SHADOWS_UNIT, GL_TEXTURE_2D_ARRAY, exponential_shadows_tex);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &exponential_blur_tex);
+    GLStateCache::BindTexture(1, GL_TEXTURE_2D, exponential_blur_tex);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+    // overrides the shadow maps' comparison while the blur reads them
+    glGenSamplers(1, &depth_read_sampler);
+    glSamplerParameteri(depth_read_sampler, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glSamplerParameteri(depth_read_sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glSamplerParameteri(depth_read_sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+    AllocateShadowMaps();
+
+    // binds the shadow map depth texture's first layer to the framebuffer (the others are bound while rendering)
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow_map_depth_tex, 0, 0);
 
     // cleanup the texture bind
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
 
     // disable color draw & read buffer for this framebuffer
     glReadBuffer(GL_NONE);
@@ -267,93 +367,766 @@ void Renderer::Init() {
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "ERROR -> Framebuffer is not complete!" << std::endl;
 
-    // cleanup the framebuffer bind
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // initializes the exponential shadow maps framebuffer, whose color attachment changes with every blur pass
+    glGenFramebuffers(1, &exponential_shadows_fbo);
+    GLStateCache::BindFramebuffer(exponential_shadows_fbo);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, exponential_blur_tex, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR -> Framebuffer is not complete!" << std::endl;
+
+    // cleanup the binds
+    GLStateCache::BindTexture(EXPONENTIAL_SHADOWS_UNIT, GL_TEXTURE_2D_ARRAY, 0);
+    GLStateCache::BindTexture(1, GL_TEXTURE_2D, 0);
+    GLStateCache::BindFramebuffer(0);
+}
+
+// every cascade of the sun & every cube face of a point light needs its own slot in the per-pass uniforms
+static_assert(Light::MAX_CASCADES <= FrameUniforms::MAX_SHADOW_MAPS, "FrameUniforms can't hold every cascade of the sun");
+static_assert(Light::CUBE_FACE_COUNT <= FrameUniforms::MAX_SHADOW_MAPS, "FrameUniforms can't hold every cube face of a point light");
+
+void Renderer::SetShadowFilter(size_t _filter) {
+    shadow_filter = _filter % SHADOW_FILTER_TAPS.size();
+
+    // materials hold on to the shared lit shader, so its program is replaced in place
+    *lit_shader = exponential_shadows ? *lit_exponential_variant : *lit_shadow_filter_variants[shadow_filter];
+}
+
+void Renderer::SetExponentialShadows(bool _enabled) {
+    exponential_shadows = _enabled;
+
+    SetShadowFilter(shadow_filter);
+}
+
+void Renderer::AllocateShadowMaps() {
+    shadow_map_size = main_light->GetShadowMapSize();
+    shadow_map_count = main_light->GetShadowMapCount();
+
+    // a static & a dynamic layer per shadow map
+    GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, shadow_map_depth_tex);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, shadow_map_size, shadow_map_size, 2 * shadow_map_count, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    // a single exponential map per shadow map, since the blur combines both layers
+    exponential_map_size = std::max(shadow_map_size / ESM_DOWNSAMPLE, 1);
+
+    GLStateCache::BindTexture(EXPONENTIAL_SHADOWS_UNIT, GL_TEXTURE_2D_ARRAY, exponential_shadows_tex);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, exponential_map_size, exponential_map_size, shadow_map_count, 0, GL_RED, GL_FLOAT, nullptr);
+
+    GLStateCache::BindTexture(1, GL_TEXTURE_2D, exponential_blur_tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, exponential_map_size, exponential_map_size, 0, GL_RED, GL_FLOAT, nullptr);
+
+    // fresh storage has nothing in it
+    shadow_cache.static_dirty = true;
+    shadow_cache.dynamic_dirty = true;
+}
+
+void Renderer::SetPointLightCount(size_t _count) {
+    point_lights.clear();
+
+    // a fixed seed, so that each count is a prefix of the next one
+    std::mt19937 generator(1337);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // scattered low over the court & its surroundings, warm or cool white
+    for (size_t i = 0; i < std::min(_count, (size_t)ClusteredLights::MAX_LIGHTS); ++i) {
+        const glm::vec3 position = glm::vec3(unit(generator) * 80.0f - 40.0f, unit(generator) * 3.0f + 0.5f, unit(generator) * 50.0f - 25.0f);
+        const glm::vec3 color = glm::mix(glm::vec3(1.0f, 0.85f, 0.6f), glm::vec3(0.7f, 0.85f, 1.0f), unit(generator));
+
+        point_lights.push_back({
+            .position = position,
+            .radius = unit(generator) * 4.0f + 6.0f,
+            .color = color,
+            .intensity = 6.0f,
+        });
+    }
+}
+
+void Renderer::UpdateLightBenchmark() {
+    if (!light_benchmark.running)
+        return;
+
+    if (light_benchmark.frame >= LIGHT_BENCHMARK_WARMUP_FRAMES) {
+        light_benchmark.render_ms += frame_stats.render_ms;
+        light_benchmark.binning_ms += clustered_lights->stats.binning_ms;
+        light_benchmark.color_pass_ms += (double)color_pass_time_query->GetResult() / 1000000.0;
+    }
+
+    if (++light_benchmark.frame < LIGHT_BENCHMARK_WARMUP_FRAMES + LIGHT_BENCHMARK_FRAMES)
+        return;
+
+    std::cout << "INFO -> Light benchmark: " << point_lights.size() << " lights, " << light_benchmark.render_ms / LIGHT_BENCHMARK_FRAMES << " ms on the CPU ("
+              << light_benchmark.binning_ms / LIGHT_BENCHMARK_FRAMES << " ms binning), " << light_benchmark.color_pass_ms / LIGHT_BENCHMARK_FRAMES << " ms color pass on the GPU" << std::endl;
+
+    light_benchmark.frame = 0;
+    light_benchmark.render_ms = light_benchmark.binning_ms = light_benchmark.color_pass_ms = 0.0;
+
+    if (++light_benchmark.step < LIGHT_BENCHMARK_COUNTS.size()) {
+        SetPointLightCount(LIGHT_BENCHMARK_COUNTS[light_benchmark.step]);
+    } else {
+        light_benchmark.running = false;
+        SetPointLightCount(light_benchmark.previous_light_count);
+    }
+}
+
+void Renderer::RenderShadowLayers(RenderQueue::Pass _pass, int _firstLayer) {
+    // a layered attachment can only be cleared as a whole, so the pass' own layers are cleared one by one first
+    for (int i = 0; i < shadow_map_count; ++i) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow_map_depth_tex, 0, _firstLayer + i);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    // every layer is attached at once, the geometry shader picking the layer of each primitive it emits
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadow_map_depth_tex, 0);
+
+    // casters are drawn once for every layer, so spheres pick their level from the first (i.e. the finest cascade's) shadow map
+    VisualSphere::SetLodView(VisualSphere::LodPass::SHADOW, main_light->GetShadowViewProjection(0), main_light->GetPosition(), main_light->GetShadowMapSize(), SHADOW_SPHERE_LOD_BIAS);
+
+    for (const auto &[render_mode, material] : shadow_mapper_materials) {
+        material.shader->SetInt("u_shadow_layer_offset", _firstLayer);
+        material.shader->instanced_variant->SetInt("u_shadow_layer_offset", _firstLayer);
+    }
+
+    // the casters are submitted once, for every shadow map
+    render_queue->Submit(_pass);
+}
+
+void Renderer::RenderShadowAtlas(FrameUniforms::Data _frameData) {
+    const auto scheduled_tiles = shadow_atlas->GetScheduledTiles();
+
+    if (scheduled_tiles.empty())
+        return;
+
+    GLStateCache::BindFramebuffer(shadow_atlas->GetFramebuffer());
+
+    // the atlas can't be sampled while it is being drawn on
+    GLStateCache::BindTexture(ShadowAtlas::ATLAS_UNIT, GL_TEXTURE_2D, 0);
+
+    // the atlas isn't layered, so every tile is a single shadow map drawn on its own part of it
+    GLStateCache::SetScissorTest(true);
+    _frameData.shadow_map_count = 1;
+
+    for (const auto &[render_mode, material] : shadow_mapper_materials) {
+        material.shader->SetInt("u_shadow_layer_offset", 0);
+        material.shader->instanced_variant->SetInt("u_shadow_layer_offset", 0);
+    }
+
+    for (int tile_index : scheduled_tiles) {
+        const auto &tile = shadow_atlas->GetTile(tile_index);
+
+        GLStateCache::Viewport(tile.offset.x, tile.offset.y, tile.size, tile.size);
+        GLStateCache::Scissor(tile.offset.x, tile.offset.y, tile.size, tile.size);
+        glClear(GL_DEPTH_BUFFER_BIT);
+
+        _frameData.shadow_view_projections[0] = tile.view_projection;
+        frame_uniforms->Upload(_frameData);
+
+        VisualSphere::SetLodView(VisualSphere::LodPass::ATLAS, tile.view_projection, point_lights[tile.light].position, tile.size, SHADOW_SPHERE_LOD_BIAS, tile_index);
+
+        // casters were collected for every scheduled light at once, each tile only draws those in its own light's reach & face
+        render_queue->SubmitInside(RenderQueue::Pass::ATLAS_SHADOW, Frustum(tile.view_projection));
+    }
+
+    GLStateCache::SetScissorTest(false);
+}
+
+void Renderer::FilterExponentialShadows() {
+    GLStateCache::BindFramebuffer(exponential_shadows_fbo);
+    GLStateCache::Viewport(0, 0, exponential_map_size, exponential_map_size);
+
+    // every texel is overwritten, and a single channel has no alpha to blend with
+    GLStateCache::SetBlend(false);
+
+    // neither texture can be sampled while it is being drawn on, while the shadow maps are read without comparison
+    GLStateCache::BindTexture(EXPONENTIAL_SHADOWS_UNIT, GL_TEXTURE_2D_ARRAY, 0);
+    GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, shadow_map_depth_tex);
+    glBindSampler(0, depth_read_sampler);
+
+    for (int i = 0; i < shadow_map_count; ++i) {
+        // both layers of the shadow map, downsampled & blurred horizontally
+        GLStateCache::BindTexture(1, GL_TEXTURE_2D, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, exponential_blur_tex, 0);
+
+        exponential_horizontal_blur_material.shader->SetInt("u_shadow_map", i);
+        main_screen->Draw(GL_TRIANGLES, &exponential_horizontal_blur_material);
+
+        // then vertically, into the shadow map's own exponential map
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, exponential_shadows_tex, 0, i);
+        GLStateCache::BindTexture(1, GL_TEXTURE_2D, exponential_blur_tex);
+
+        exponential_vertical_blur_material.shader->SetInt("u_shadow_map", i);
+        main_screen->Draw(GL_TRIANGLES, &exponential_vertical_blur_material);
+    }
+
+    glBindSampler(0, 0);
+    GLStateCache::SetBlend(true);
+}
+
+const Shader::Material *Renderer::GetShadowMapperMaterial(int _renderMode) const {
+    switch (_renderMode) {
+        case GL_POINTS:
+            return &shadow_mapper_materials.at(GL_POINTS);
+        case GL_LINES:
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            return &shadow_mapper_materials.at(GL_LINES);
+        default:
+            return &shadow_mapper_materials.at(GL_TRIANGLES);
+    }
 }
 
 void Renderer::Render(GLFWwindow *_window, const double _deltaTime)
 {
+    const auto render_start_time = std::chrono::steady_clock::now();
+
     // processes input
     InputCallback(_window, _deltaTime);
 
+    scene_bvh->ResetStats();
+
+    VisualObject::draw_calls = 0;
+    VisualSphere::lod_draw_calls.fill(0);
+    GLStateCache::ResetStats();
+
     // moves the main light
     auto light_turning_radius = 4.0f;
     if (light_movement)
         main_light->SetPosition(glm::vec3(glm::cos(glfwGetTime() * 2.0f) * light_turning_radius, 10.0f * glm::sin(glfwGetTime() / 2.0f) + 15.0f, glm::sin(glfwGetTime()) *  light_turning_radius));
 
+    main_light_cube->position = main_light->GetPosition();
+    MoveRenderable(main_light_cube_renderable, main_light_cube->GetModelMatrix());
+
+    // racket poses are shared by both passes
+    const auto pose_start_time = std::chrono::steady_clock::now();
+    if (EvaluateRacketPoses())
+        shadow_cache.dynamic_dirty = true;
+    frame_stats.pose_evaluation_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pose_start_time).count();
+
+    // once every renderable moved for this frame
+    scene_bvh->RebuildIfDegraded();
+
+    // the net & the ground never move, so only the rackets & the way they are drawn can invalidate the dynamic layers
+    if (racket_render_mode != shadow_cache.racket_render_mode) {
+        shadow_cache.racket_render_mode = racket_render_mode;
+        shadow_cache.dynamic_dirty = true;
+
+        for (const auto &rig : racket_rigs)
+            shadow_atlas->InvalidateBounds(rig.world_bounds);
+    }
+
+    if (exponential_shadows != shadow_cache.exponential_shadows) {
+        shadow_cache.exponential_shadows = exponential_shadows;
+        shadow_cache.dynamic_dirty = true;
+    }
+
+    if (shadow_mode != shadow_cache.shadow_mode) {
+        shadow_cache.shadow_mode = shadow_mode;
+        shadow_cache.static_dirty = true;
+        shadow_cache.dynamic_dirty = true;
+    }
+
+    if (main_light->GetShadowMapSize() != shadow_map_size || main_light->GetShadowMapCount() != shadow_map_count)
+        AllocateShadowMaps();
+
+    // every draw of every pass is collected first, then sorted once
+    render_queue->Clear();
+
+    // SHADOW MAP PASSES (collection)
+
+    // the shadow maps are fitted to the casters & the ground (the main receiver), so they're only refitted when those changed
+    const bool static_changed = shadow_cache.static_dirty;
+    const bool dynamic_changed = shadow_cache.dynamic_dirty;
+
+    if (static_changed)
+        shadow_cache.fitted_bounds = GetShadowCasterBounds(SCENE_STATIC_SHADOW);
+
+    if (dynamic_changed) {
+        const Bounds dynamic_bounds = GetShadowCasterBounds(SCENE_DYNAMIC_SHADOW);
+
+        if (!shadow_cache.fitted_bounds.Contains(dynamic_bounds))
+            shadow_cache.fitted_bounds.Add(dynamic_bounds);
+    }
+
+    if (static_changed || dynamic_changed)
+        main_light->FitShadowBounds(shadow_cache.fitted_bounds);
+
+    // the sun's cascades follow the camera's frustum
+    if (main_light->GetMode() == Light::Mode::SUN)
+        main_light->UpdateCascades(*main_camera);
+
+    // every layer is seen from the light, so moving it invalidates all of them
+    if (main_light->IsShadowDirty()) {
+        shadow_cache.static_dirty = true;
+        shadow_cache.dynamic_dirty = true;
+    }
+
+    // casters are only collected once every shadow map's view is final for this frame, since the BVH only finds those inside of them
+    if (shadow_cache.static_dirty)
+        CollectShadowCasters(RenderQueue::Pass::STATIC_SHADOW);
+
+    if (shadow_cache.dynamic_dirty)
+        CollectShadowCasters(RenderQueue::Pass::DYNAMIC_SHADOW);
+
+    frame_stats.culled_shadow_casters = CullShadowCasters();
+
+    FrameUniforms::Data frame_data = {
+        .ambient_strength = main_light->ambient_strength,
+        .light_pos = main_light->GetPosition(),
+        .specular_strength = main_light->specular_strength,
+        .light_color = main_light->GetColor(),
+        .shadows_influence = 1.0f - (float)main_light->project_shadows,
+        .shadow_map_count = shadow_map_count,
+        .cluster_count_x = ClusteredLights::CLUSTER_COUNT_X,
+        .cluster_count_y = ClusteredLights::CLUSTER_COUNT_Y,
+        .cluster_count_z = ClusteredLights::CLUSTER_COUNT_Z,
+        .cluster_depth_params = ClusteredLights::GetDepthParams(),
+        .cluster_tile_size = ClusteredLights::GetTileSize(viewport_width, viewport_height),
+    };
+
+    for (int i = 0; i < shadow_map_count; ++i) {
+        frame_data.shadow_view_projections[i] = main_light->GetShadowViewProjection(i);
+        frame_data.shadow_depth_params[i] = glm::vec4(main_light->GetShadowDepthBias(i), main_light->GetShadowDepthRatio(i), 0.0f, 0.0f);
+    }
+
+    // POINT LIGHTS (binned for the camera's current view, once the atlas picked which of them are shadowed)
+    shadow_atlas->Update(point_lights, *main_camera, shadow_mode);
+    clustered_lights->Update(point_lights, *main_camera);
+
+    // every caster may be in any tile, so they are all collected whenever a tile has to be rendered
+    if (!shadow_atlas->GetScheduledTiles().empty())
+        CollectShadowCasters(RenderQueue::Pass::ATLAS_SHADOW);
+
+    // COLOR PASS (collection)
+    render_queue->SetPass(RenderQueue::Pass::COLOR, main_camera->GetPosition(), Camera::FAR_PLANE);
+
+    // draws the world cube, after everything else that is opaque, since it covers the whole background (it surrounds the camera, so it is never culled)
+    render_queue->Push(world_cube.get(), world_cube->GetModelMatrix(), GL_TRIANGLES, nullptr, RenderQueue::Layer::BACKGROUND);
+
+    // CAMERA CULLING (whatever is outside of the camera's view never reaches the draw calls)
+
+    // only the renderables the BVH finds in the camera's view are pushed
+    scene_query_results.clear();
+    scene_bvh->QueryFrustums(std::span(&main_camera->GetFrustum(), 1), SCENE_VISIBLE, scene_query_results);
+
+    const size_t in_view_count = scene_query_results.size();
+
+    // SOFTWARE OCCLUSION CULLING (renderables behind the largest occluders, rasterized on the CPU this frame, so without any latency)
+    if (software_occlusion) {
+        occlusion_rasterizer->Rasterize(main_camera->GetViewProjection());
+
+        std::erase_if(scene_query_results, [this](uint32_t _index) { return occlusion_rasterizer->IsOccluded(scene_bvh->GetBounds(renderables[_index].proxy)); });
+    }
+
+    frame_stats.software_occluded_objects = (int)(in_view_count - scene_query_results.size());
+
+    // OCCLUSION CULLING (rackets that were hidden by the net, the ground or each other last frame)
+    for (auto &occlusion : racket_occlusions)
+        occlusion.in_view = false;
+
+    for (const auto index : scene_query_results) {
+        if (renderables[index].racket >= 0)
+            racket_occlusions[renderables[index].racket].in_view = true;
+    }
+
+    UpdateRacketOcclusions();
+
+    for (const auto index : scene_query_results) {
+        const auto &renderable = renderables[index];
+        GLuint condition_query = 0;
+
+        if (renderable.racket >= 0) {
+            const auto &occlusion = racket_occlusions[renderable.racket];
+
+            if (occlusion.hidden)
+                continue;
+
+            condition_query = occlusion.condition_query;
+        }
+
+        if (renderable.string) {
+            racket_string_batches[renderable.racket].push_back(index);
+            continue;
+        }
+
+        render_queue->SetCondition(condition_query);
+        render_queue->Push(renderable.object, renderable.transform, GetRenderMode(renderable), renderable.material);
+    }
+
+    PushRacketStrings(false);
+    render_queue->SetCondition(0);
+
+    // the BVH only tests fattened boxes, so its packets are tested again against their own box & sphere
+    frame_stats.culled_objects = (int)(renderables.size() - in_view_count) + render_queue->Cull(RenderQueue::Pass::COLOR, std::span(&main_camera->GetFrustum(), 1));
+    frame_stats.visible_objects = render_queue->GetPacketCount(RenderQueue::Pass::COLOR);
+
+    render_queue->Sort();
+
     // SHADOW MAP PASS
 
-    // binds the shadow map framebuffer and the depth texture to draw on it
-    glBindFramebuffer(GL_FRAMEBUFFER, shadow_map_fbo);
-    glViewport(0, 0, Light::LIGHTMAP_SIZE, Light::LIGHTMAP_SIZE);
-    glBindTexture(GL_TEXTURE_2D, shadow_map_depth_tex);
+    // otherwise, the layers of the previous frame are still valid as they are
+    if (shadow_cache.static_dirty || shadow_cache.dynamic_dirty) {
+        // binds the shadow map framebuffer to draw on its depth texture
+        GLStateCache::BindFramebuffer(shadow_map_fbo);
+        GLStateCache::Viewport(0, 0, shadow_map_size, shadow_map_size);
 
-    // clears the depth canvas to black
-    glClear(GL_DEPTH_BUFFER_BIT);
+        // the depth texture can't be sampled while it is being drawn on
+        GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
 
-    if (shadow_mode) {
-        // draws the net
-        DrawOneNet(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), main_light->GetViewProjection(), main_light->GetPosition(), shadow_mapper_material.get());
+        // every shadow map's view is read from the per-pass uniforms by the shadow mappers' geometry shader
+        frame_data.cam_pos = main_light->GetPosition();
+        frame_uniforms->Upload(frame_data);
 
-        // draws the rackets
-        DrawOneAugustoRacket(rackets[0].position, rackets[0].rotation, rackets[0].scale, main_light->GetViewProjection(), main_light->GetPosition(), shadow_mapper_material.get());
-        DrawOneGabrielleRacket(rackets[1].position, rackets[1].rotation, rackets[1].scale, main_light->GetViewProjection(), main_light->GetPosition(), shadow_mapper_material.get());
-        DrawOneJackRacket(rackets[2].position, rackets[2].rotation, rackets[2].scale, main_light->GetViewProjection(), main_light->GetPosition(), shadow_mapper_material.get());
+        if (shadow_cache.static_dirty)
+            RenderShadowLayers(RenderQueue::Pass::STATIC_SHADOW, 0);
 
-        ground_plane->Draw(main_light->GetViewProjection(), main_light->GetPosition(), GL_TRIANGLES, shadow_mapper_material.get());
+        if (shadow_cache.dynamic_dirty)
+            RenderShadowLayers(RenderQueue::Pass::DYNAMIC_SHADOW, shadow_map_count);
+
+        if (exponential_shadows)
+            FilterExponentialShadows();
+
+        // unbind the shadow map framebuffer
+        GLStateCache::BindFramebuffer(0);
+
+        shadow_cache.static_rendered_passes += shadow_cache.static_dirty;
+        shadow_cache.dynamic_rendered_passes += shadow_cache.dynamic_dirty;
+
+        shadow_cache.static_dirty = false;
+        shadow_cache.dynamic_dirty = false;
+        main_light->ClearShadowDirty();
+    } else {
+        ++shadow_cache.skipped_passes;
     }
 
-    // unbind the current texture & framebuffer
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // POINT LIGHT SHADOW ATLAS (only this frame's share of its tiles)
+    RenderShadowAtlas(frame_data);
+    GLStateCache::BindFramebuffer(0);
+
+    frame_stats.shadow_draw_calls = VisualObject::draw_calls;
+    VisualObject::draw_calls = 0;
+    GLStateCache::ResetStats();
 
     // COLOR PASS
 
+    // everything is seen from the camera's perspective, while shadows are still looked up in the light's
+    frame_data.view_projection = main_camera->GetViewProjection();
+    frame_data.cam_pos = main_camera->GetPosition();
+    frame_uniforms->Upload(frame_data);
+
+    // the depth prepass & the color pass share the same levels, so that their depths match exactly
+    VisualSphere::SetLodView(VisualSphere::LodPass::COLOR, main_camera->GetViewProjection(), main_camera->GetPosition(), viewport_height, SPHERE_LOD_BIAS);
+
     // resets the viewport to the window size
-    glViewport(0, 0, viewport_width, viewport_height);
+    GLStateCache::Viewport(0, 0, viewport_width, viewport_height);
 
-    // activates the shadow map depth texture & binds it to the first texture unit, so that it can be used by the lit shader
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, shadow_map_depth_tex);
+    // binds the shadow map depth texture to the first texture unit, so that it can be used by the lit shader
+    GLStateCache::BindTexture(0, GL_TEXTURE_2D_ARRAY, shadow_map_depth_tex);
+    GLStateCache::BindTexture(EXPONENTIAL_SHADOWS_UNIT, GL_TEXTURE_2D_ARRAY, exponential_shadows_tex);
+    clustered_lights->Bind();
+    shadow_atlas->Bind();
 
     // clears the color & depth canvas to black
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // draws the world cube
-    world_cube->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
+    color_pass_time_query->Begin();
 
-    // draws the main light cube
-    main_light_cube->position = main_light->GetPosition();
-    main_light_cube->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
+    if (depth_prepass) {
+        // DEPTH PREPASS
+
+        // opaque geometry only fills the depth buffer first, with no color writes & a fragment shader that does nothing
+        GLStateCache::ColorMask(false);
+        render_queue->SubmitDepth(RenderQueue::Pass::COLOR, RenderQueue::Layer::OPAQUE, RenderQueue::Layer::OPAQUE, *depth_prepass_material);
+        GLStateCache::ColorMask(true);
+
+        frame_stats.depth_prepass_draw_calls = VisualObject::draw_calls;
+        VisualObject::draw_calls = 0;
+
+        // the depth buffer is already final for opaque geometry, so only the fragments that ended up visible are shaded
+        // GL_LEQUAL rather than GL_EQUAL, so that lines & points (whose rasterization may differ slightly) aren't lost
+        color_pass_samples_query->Begin();
+
+        GLStateCache::DepthFunc(GL_LEQUAL);
+        GLStateCache::DepthMask(false);
+        render_queue->Submit(RenderQueue::Pass::COLOR, RenderQueue::Layer::OPAQUE, RenderQueue::Layer::OPAQUE);
+        GLStateCache::DepthMask(true);
+        GLStateCache::DepthFunc(GL_LESS);
 
-    // draws the main grid
-    main_grid->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
+        render_queue->Submit(RenderQueue::Pass::COLOR, RenderQueue::Layer::BACKGROUND, RenderQueue::Layer::TRANSLUCENT);
+    } else {
+        frame_stats.depth_prepass_draw_calls = 0;
 
-    // draws the coordinate axis
-    main_x_line->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
-    main_y_line->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
-    main_z_line->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
+        color_pass_samples_query->Begin();
 
-    // draws the net
-    DrawOneNet(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), main_camera->GetViewProjection(), main_camera->GetPosition());
+        render_queue->Submit(RenderQueue::Pass::COLOR);
+    }
+
+    color_pass_samples_query->End();
 
-    // draws the rackets
-    DrawOneAugustoRacket(rackets[0].position, rackets[0].rotation, rackets[0].scale, main_camera->GetViewProjection(), main_camera->GetPosition());
-    DrawOneGabrielleRacket(rackets[1].position, rackets[1].rotation, rackets[1].scale, main_camera->GetViewProjection(), main_camera->GetPosition());
-    DrawOneJackRacket(rackets[2].position, rackets[2].rotation, rackets[2].scale, main_camera->GetViewProjection(), main_camera->GetPosition());
+    // tests the rackets against the final depth of this frame, for the next one
+    RenderOcclusionQueries();
+
+    color_pass_time_query->End();
 
-    ground_plane->Draw(main_camera->GetViewProjection(), main_camera->GetPosition());
     // can be used for post-processing effects
     //main_screen->Draw();
+
+    frame_stats.color_draw_calls = VisualObject::draw_calls;
+    frame_stats.render_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - render_start_time).count();
+
+    UpdateLightBenchmark();
 }
 
-void Renderer::DrawOneNet(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection, const glm::vec3& _eyePosition, const Shader::Material *_materialOverride)
+void Renderer::BuildScene()
 {
+    scene_bvh = std::make_unique<BoundingVolumeHierarchy>();
+    renderables.clear();
+
+    // follows the main light, moved every frame
+    main_light_cube_renderable = AddRenderable({.object = main_light_cube.get()});
+
+    AddRenderable({.object = main_grid.get(), .transform = main_grid->GetModelMatrix(), .render_mode = GL_LINES});
+
+    // coordinate axis
+    AddRenderable({.object = main_x_line.get(), .transform = main_x_line->GetModelMatrix(), .render_mode = GL_LINES});
+    AddRenderable({.object = main_y_line.get(), .transform = main_y_line->GetModelMatrix(), .render_mode = GL_LINES});
+    AddRenderable({.object = main_z_line.get(), .transform = main_z_line->GetModelMatrix(), .render_mode = GL_LINES});
+
+    // the net & the ground never move, so they are in the static shadow layers
+    for (auto &net_model : net_models)
+        AddRenderable({.object = net_model.get(), .scene_mask = SCENE_VISIBLE | SCENE_STATIC_SHADOW});
+
+    AddRenderable({.object = ground_plane.get(), .transform = ground_plane->GetModelMatrix(), .scene_mask = SCENE_VISIBLE | SCENE_STATIC_SHADOW});
+
+    // racket parts are only placed once their racket's pose is first evaluated
+    racket_renderables = std::vector<std::vector<size_t>>(racket_rigs.size());
+
+    for (size_t i = 0; i < racket_rigs.size(); ++i)
+    {
+        for (const auto &part : racket_rigs[i].parts)
+        {
+            racket_renderables[i].push_back(AddRenderable({
+                .object = part.object,
+                .material = part.material,
+                .render_mode = part.follows_render_mode ? RACKET_RENDER_MODE : GL_TRIANGLES,
+                .scene_mask = SCENE_VISIBLE | SCENE_DYNAMIC_SHADOW | SCENE_PICKABLE,
+                .racket = (int)i,
+                .string = part.string,
+            }));
+        }
+    }
+
+    // renderables were inserted one by one, the tree starts from a proper top-down build instead
+    scene_bvh->Rebuild();
+
+    racket_occlusions = std::vector<RacketOcclusion>(racket_rigs.size());
+    racket_string_batches = std::vector<std::vector<size_t>>(racket_rigs.size());
+
+    for (auto &occlusion : racket_occlusions)
+        occlusion.query = std::make_unique<GLQuery>(GL_ANY_SAMPLES_PASSED);
+
+    // the largest opaque boxes of the scene hide the rest from the software occlusion culling (the world cube's inside only hides what's outside of it)
+    occlusion_rasterizer = std::make_unique<SoftwareOcclusion>();
+    occlusion_rasterizer->AddOccluderBox(ground_plane->GetLocalBounds(), ground_plane->GetModelMatrix());
+    occlusion_rasterizer->AddOccluderBox(world_cube->GetLocalBounds(), world_cube->GetModelMatrix());
+
+    for (const auto &post_transform : net_post_transforms)
+        occlusion_rasterizer->AddOccluderBox(net_cubes[0].GetLocalBounds(), post_transform);
+}
+
+size_t Renderer::AddRenderable(const Renderable &_renderable)
+{
+    const size_t index = renderables.size();
+
+    renderables.push_back(_renderable);
+    renderables.back().proxy = scene_bvh->Insert(_renderable.object->GetLocalBounds().Transformed(_renderable.transform), _renderable.scene_mask, (uint32_t)index);
+
+    return index;
+}
+
+void Renderer::MoveRenderable(size_t _index, const glm::mat4 &_transformMatrix)
+{
+    auto &renderable = renderables[_index];
+
+    renderable.transform = _transformMatrix;
+    scene_bvh->Move(renderable.proxy, renderable.object->GetLocalBounds().Transformed(_transformMatrix));
+}
+
+int Renderer::GetRenderMode(const Renderable &_renderable) const
+{
+    return _renderable.render_mode == RACKET_RENDER_MODE ? racket_render_mode : _renderable.render_mode;
+}
+
+void Renderer::PickRacket(GLFWwindow *_window)
+{
+    int window_width, window_height;
+    glfwGetWindowSize(_window, &window_width, &window_height);
+
+    if (window_width <= 0 || window_height <= 0)
+        return;
+
+    // the cursor is in window coordinates, from the top left corner
+    const auto ndc_x = (float)(2.0 * Input::cursor_x / window_width - 1.0);
+    const auto ndc_y = (float)(1.0 - 2.0 * Input::cursor_y / window_height);
+
+    // racket parts are only picked by their boxes, which is precise enough to tell rackets apart
+    const auto hit = scene_bvh->Raycast(main_camera->GetPosition(), main_camera->GetRayDirection(ndc_x, ndc_y), Camera::FAR_PLANE, SCENE_PICKABLE);
+
+    if (!hit.has_value())
+    {
+        std::cout << "INFO -> Nothing to pick under the cursor" << std::endl;
+        return;
+    }
+
+    selected_player = renderables[hit->user_data].racket;
+
+    std::cout << "INFO -> Picked racket " << selected_player + 1 << ", " << hit->distance << " units away" << std::endl;
+}
+
+void Renderer::CollectShadowCasters(RenderQueue::Pass _pass)
+{
+    if (!shadow_mode)
+        return;
+
+    render_queue->SetPass(_pass, main_light->GetPosition(), Light::FAR_PLANE);
+
+    scene_query_results.clear();
+
+    if (_pass == RenderQueue::Pass::ATLAS_SHADOW) {
+        // a point light doesn't reach past its radius, so only the casters within it can be in its tiles
+        std::vector<size_t> queried_lights;
+
+        for (const int tile_index : shadow_atlas->GetScheduledTiles()) {
+            const size_t light_index = shadow_atlas->GetTile(tile_index).light;
+
+            if (std::find(queried_lights.begin(), queried_lights.end(), light_index) != queried_lights.end())
+                continue;
+
+            queried_lights.push_back(light_index);
+
+            const auto &light = point_lights[light_index];
+            scene_bvh->QuerySphere(light.position, light.radius, SCENE_STATIC_SHADOW | SCENE_DYNAMIC_SHADOW, scene_query_results);
+        }
+
+        // casters in reach of several lights are only drawn once, into every tile
+        std::sort(scene_query_results.begin(), scene_query_results.end());
+        scene_query_results.erase(std::unique(scene_query_results.begin(), scene_query_results.end()), scene_query_results.end());
+    } else {
+        std::array<Frustum, FrameUniforms::MAX_SHADOW_MAPS> shadow_map_frustums;
+
+        for (int i = 0; i < shadow_map_count; ++i)
+            shadow_map_frustums[i] = Frustum(main_light->GetShadowViewProjection(i));
+
+        const uint32_t scene_mask = _pass == RenderQueue::Pass::STATIC_SHADOW ? SCENE_STATIC_SHADOW : SCENE_DYNAMIC_SHADOW;
+
+        scene_bvh->QueryFrustums(std::span(shadow_map_frustums).first(shadow_map_count), scene_mask, scene_query_results);
+    }
+
+    for (const auto index : scene_query_results) {
+        const auto &renderable = renderables[index];
+
+        if (renderable.string) {
+            racket_string_batches[renderable.racket].push_back(index);
+            continue;
+        }
+
+        PushShadowCaster(renderable.object, renderable.transform, GetRenderMode(renderable), renderable.material);
+    }
+
+    PushRacketStrings(true);
+}
+
+Bounds Renderer::GetShadowCasterBounds(uint32_t _sceneMask) const
+{
+    Bounds bounds;
+
+    if (!shadow_mode)
+        return bounds;
+
+    std::vector<uint32_t> found_renderables;
+    scene_bvh->QueryMask(_sceneMask, found_renderables);
+
+    for (const auto index : found_renderables)
+        bounds.Add(scene_bvh->GetBounds(renderables[index].proxy));
+
+    return bounds;
+}
+
+void Renderer::PushShadowCaster(VisualObject *_object, const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
+{
+    const Shader::Material &material = _material != nullptr ? *_material : _object->material;
+
+    // receivers that don't cast still have to be covered by the shadow maps, so they only count towards the pass' bounds
+    if (!material.casts_shadows) {
+        render_queue->PushBounds(_object->GetLocalBounds().Transformed(_transformMatrix));
+        return;
+    }
+
+    render_queue->Push(_object, _transformMatrix, _renderMode, GetShadowMapperMaterial(_renderMode));
+}
+
+void Renderer::PushRacketStrings(bool _shadowCasters)
+{
+    for (size_t i = 0; i < racket_string_batches.size(); ++i)
+    {
+        auto &batch = racket_string_batches[i];
+
+        if (batch.empty())
+            continue;
+
+        // every string of a racket shares the first one's object, material & render mode
+        const auto &first_string = renderables[batch.front()];
+        const int render_mode = GetRenderMode(first_string);
+        const Shader::Material &material = first_string.material != nullptr ? *first_string.material : first_string.object->material;
+
+        string_transforms.clear();
+
+        for (const auto index : batch)
+            string_transforms.push_back(renderables[index].transform);
+
+        batch.clear();
+
+        if (!_shadowCasters)
+        {
+            render_queue->SetCondition(racket_occlusions[i].condition_query);
+            render_queue->PushInstanced(first_string.object, string_transforms, {}, render_mode, &material);
+        }
+        else if (material.casts_shadows)
+        {
+            render_queue->PushInstanced(first_string.object, string_transforms, {}, render_mode, GetShadowMapperMaterial(render_mode));
+        }
+        else
+        {
+            // same as PushShadowCaster, the strings still have to be covered by the shadow maps
+            for (const auto &transform_matrix : string_transforms)
+                render_queue->PushBounds(first_string.object->GetLocalBounds().Transformed(transform_matrix));
+        }
+    }
+}
+
+int Renderer::CullShadowCasters()
+{
+    // the light's shadow maps only change when their passes are re-rendered, so there is nothing to cull otherwise
+    if (!shadow_cache.static_dirty && !shadow_cache.dynamic_dirty)
+        return 0;
+
+    std::array<Frustum, FrameUniforms::MAX_SHADOW_MAPS> shadow_map_frustums;
+
+    for (int i = 0; i < shadow_map_count; ++i)
+        shadow_map_frustums[i] = Frustum(main_light->GetShadowViewProjection(i));
+
+    // a caster is drawn into every shadow map by the geometry shader, so it is kept as long as it is inside any of them
+    const auto frustums = std::span(shadow_map_frustums).first(shadow_map_count);
+
+    return render_queue->Cull(RenderQueue::Pass::STATIC_SHADOW, frustums) + render_queue->Cull(RenderQueue::Pass::DYNAMIC_SHADOW, frustums);
+}
+
+void Renderer::BakeNet()
+{
+    // the net's parts never move relative to each other, so they are collected once and baked per material
+    std::vector<glm::mat4> post_transforms;
+    std::vector<glm::mat4> net_transforms;
+
     glm::mat4 world_transform_matrix = glm::mat4(1.0f);
-    // global transforms
-    world_transform_matrix = glm::translate(world_transform_matrix, _position);
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, _rotation);
-    world_transform_matrix = glm::scale(world_transform_matrix, _scale);
 
     auto scale_factor = glm::vec3(0.0f);
 
@@ -361,7 +1134,7 @@ void Renderer::DrawOneNet(const glm::vec3 &_position, const glm::vec3 &_rotation
     scale_factor = glm::vec3(1.0f, 8.0f, 1.0f);
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -18.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    net_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    post_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     // horizontal net
@@ -373,7 +1146,7 @@ void Renderer::DrawOneNet(const glm::vec3 &_position, const glm::vec3 &_rotation
     {
         world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -1.0f));
         world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-        net_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,  GL_TRIANGLES, _materialOverride);
+        net_transforms.push_back(world_transform_matrix);
         world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
     }
 
@@ -389,7 +1162,7 @@ void Renderer::DrawOneNet(const glm::vec3 &_position, const glm::vec3 &_rotation
     {
         world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, 1.0f));
         world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-        net_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+        net_transforms.push_back(world_transform_matrix);
         world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
     }
 
@@ -397,95 +1170,211 @@ void Renderer::DrawOneNet(const glm::vec3 &_position, const glm::vec3 &_rotation
     scale_factor = glm::vec3(1.0f, 8.0f, 1.0f);
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, -1.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    net_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
-    world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+    post_transforms.push_back(world_transform_matrix);
+
+    net_post_transforms = post_transforms;
+
+    net_models.clear();
+    net_models.push_back(std::make_unique<VisualBakedModel>(*net_cubes[0].GetMesh(), post_transforms, net_cubes[0].material));
+    net_models.push_back(std::make_unique<VisualBakedModel>(*net_cubes[1].GetMesh(), net_transforms, net_cubes[1].material));
 }
 
-void Renderer::DrawOneAugustoRacket(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride)
+void Renderer::UpdateRacketOcclusions()
 {
-    glm::mat4 world_transform_matrix = glm::mat4(1.0f);
-    // global transforms
-    world_transform_matrix = glm::translate(world_transform_matrix, _position);
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, _rotation);
-    world_transform_matrix = glm::scale(world_transform_matrix, _scale);
+    frame_stats.occluded_rackets = 0;
+    frame_stats.conditional_rackets = 0;
+
+    for (size_t i = 0; i < racket_occlusions.size(); ++i)
+    {
+        auto &occlusion = racket_occlusions[i];
+
+        occlusion.hidden = false;
+        occlusion.condition_query = 0;
+
+        // with the camera inside of the box, its faces are clipped or behind the racket itself, so it would be hidden for nothing
+        Bounds box_bounds = racket_rigs[i].world_bounds;
+        box_bounds.min -= glm::vec3(OCCLUSION_BOX_MARGIN + Camera::NEAR_PLANE);
+        box_bounds.max += glm::vec3(OCCLUSION_BOX_MARGIN + Camera::NEAR_PLANE);
+
+        const glm::vec3 camera_position = main_camera->GetPosition();
+        const bool camera_inside = box_bounds.Contains(Bounds{.min = camera_position, .max = camera_position});
+
+        occlusion.tested = occlusion_culling && occlusion.in_view && !camera_inside;
+
+        if (!occlusion.tested || !occlusion.tested_last_frame)
+            continue;
+
+        GLuint64 any_samples_passed = 0;
+
+        if (occlusion.query->PollLastEnded(any_samples_passed))
+        {
+            occlusion.hidden = any_samples_passed == 0;
+            frame_stats.occluded_rackets += occlusion.hidden;
+        }
+        else
+        {
+            occlusion.condition_query = occlusion.query->GetLastEnded();
+            ++frame_stats.conditional_rackets;
+        }
+    }
+}
+
+void Renderer::RenderOcclusionQueries()
+{
+    frame_stats.occlusion_queries = 0;
+
+    // the boxes are only tested against the depth buffer, nothing of them is ever seen
+    GLStateCache::ColorMask(false);
+    GLStateCache::DepthMask(false);
+
+    for (size_t i = 0; i < racket_occlusions.size(); ++i)
+    {
+        auto &occlusion = racket_occlusions[i];
+        occlusion.tested_last_frame = occlusion.tested;
+
+        if (!occlusion.tested)
+            continue;
 
+        occlusion.query->Begin();
+        occlusion_box->DrawDepth(GetOcclusionBoxTransform(racket_rigs[i].world_bounds), GL_TRIANGLES, *depth_prepass_material);
+        occlusion.query->End();
+
+        ++frame_stats.occlusion_queries;
+    }
+
+    GLStateCache::DepthMask(true);
+    GLStateCache::ColorMask(true);
+}
+
+glm::mat4 Renderer::GetOcclusionBoxTransform(const Bounds &_bounds) const
+{
+    // the box's own geometry is brought to the unit cube first, then stretched over the bounds
+    const Bounds &box_bounds = occlusion_box->GetLocalBounds();
+
+    glm::mat4 transform_matrix = glm::translate(glm::mat4(1.0f), _bounds.Center());
+    transform_matrix = glm::scale(transform_matrix, (_bounds.max - _bounds.min + glm::vec3(2.0f * OCCLUSION_BOX_MARGIN)) / (box_bounds.max - box_bounds.min));
+    transform_matrix = glm::translate(transform_matrix, -box_bounds.Center());
+
+    return transform_matrix;
+}
+
+bool Renderer::EvaluateRacketPoses()
+{
+    bool any_moved = false;
+
+    for (size_t i = 0; i < racket_rigs.size(); ++i)
+    {
+        auto &rig = racket_rigs[i];
+        const auto &racket = rackets[i];
+
+        // a racket that didn't move keeps the world transforms of its last evaluation
+        if (rig.evaluated_pose == racket)
+            continue;
+
+        rig.evaluated_pose = racket;
+        any_moved = true;
+
+        glm::mat4 root_transform_matrix = glm::mat4(1.0f);
+        root_transform_matrix = glm::translate(root_transform_matrix, racket.position);
+        root_transform_matrix = Transforms::RotateDegrees(root_transform_matrix, racket.rotation);
+        root_transform_matrix = glm::scale(root_transform_matrix, racket.scale);
+
+        const glm::mat4 elbow_transform_matrix = Transforms::RotateDegrees(root_transform_matrix * rig.elbow_transform, racket.upper_arm_rot);
+
+        rig.world_transforms.resize(rig.parts.size());
+
+        // the point lights' tiles that saw the racket where it was, then those that see it where it is now, are rendered first
+        shadow_atlas->InvalidateBounds(rig.world_bounds);
+
+        rig.world_bounds = Bounds();
+
+        // parts follow their racket in the scene's BVH
+        for (size_t j = 0; j < rig.parts.size(); ++j)
+        {
+            rig.world_transforms[j] = (rig.parts[j].articulated ? elbow_transform_matrix : root_transform_matrix) * rig.parts[j].local_transform;
+            MoveRenderable(racket_renderables[i][j], rig.world_transforms[j]);
+
+            rig.world_bounds.Add(scene_bvh->GetBounds(renderables[racket_renderables[i][j]].proxy));
+        }
+
+        shadow_atlas->InvalidateBounds(rig.world_bounds);
+    }
+
+    return any_moved;
+}
+
+void Renderer::BuildAugustoRacketRig(RacketRig &_rig)
+{
+    // the racket's own transform is only known per frame, so every part is relative to it
+    glm::mat4 world_transform_matrix = glm::mat4(1.0f);
     // letter A
-    DrawOneA(world_transform_matrix, _viewProjection, _eyePosition, _materialOverride);
+    BuildOneA(_rig, world_transform_matrix);
 
     // tennis ball
     glm::mat4 third_transform_matrix = world_transform_matrix;
     third_transform_matrix = glm::translate(third_transform_matrix, glm::vec3(2.0f, 15.0f, 2.0f));
-    tennis_balls[0].DrawFromMatrix(_viewProjection, _eyePosition, third_transform_matrix, racket_render_mode, _materialOverride);
+    _rig.AddPart(&tennis_balls[0], third_transform_matrix);
 
     // forearm (skin)
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(45.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 5.0f, 1.0f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                           nullptr ? &augusto_racket_materials[0] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[0]);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 0.2f, 1.0f));
 
     // arm (skin)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 5.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, rackets[0].upper_arm_rot);
+    world_transform_matrix = _rig.BeginElbow(world_transform_matrix); // the upper arm's rotation is applied here, once per frame
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 4.0f, 1.0f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[0] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[0]);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 0.25f, 1.0f));
 
     // racket handle (black plastic)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 4.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 4.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[1] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[1]);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.25f, 2.0f));
 
     // racket angled bottom left (blue plastic)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 4.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(-60.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 2.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[2] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[2]);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.5f, 2.0f));
 
     // racket vertical left (green plastic)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 2.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(60.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 3.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[3] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[3]);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1.0f / 3.0f, 2.0f));
 
     // racket angled top left (blue plastic)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 3.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(60.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 1.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[2] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[2]);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1.0f, 2.0f));
 
     // racket horizontal top (green plastic)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(30.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 1.6f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[3] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[3]);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1.0f / 1.6f, 2.0f));
 
     // racket angled top right (blue plastic)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.6f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(30.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 1.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[2] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[2]);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1.0f, 2.0f));
 
     // racket vertical right (green plastic)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(60.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 3.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[3] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[3]);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1.0f / 3.0f, 2.0f));
 
     // racket horizontal bottom (blue plastic)
@@ -494,8 +1383,7 @@ void Renderer::DrawOneAugustoRacket(const glm::vec3 &_position, const glm::vec3
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 3.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(90.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, horizontal_bottom_scale);
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[2] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[2]);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / horizontal_bottom_scale);
 
     // racket net vertical (white plastic)
@@ -514,8 +1402,7 @@ void Renderer::DrawOneAugustoRacket(const glm::vec3 &_position, const glm::vec3
     // done separately because it has a different offset (for aesthetic purposes)
     world_transform_matrix = glm::translate(world_transform_matrix, net_first_v_translate);
     world_transform_matrix = glm::scale(world_transform_matrix, net_v_scale);
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[4] : _materialOverride);
+    _rig.AddString(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[4]);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / net_v_scale);
 
     // the rest of the net parts
@@ -523,8 +1410,7 @@ void Renderer::DrawOneAugustoRacket(const glm::vec3 &_position, const glm::vec3
     {
         world_transform_matrix = glm::translate(world_transform_matrix, net_v_translate);
         world_transform_matrix = glm::scale(world_transform_matrix, net_v_scale);
-        augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                       nullptr ? &augusto_racket_materials[4] : _materialOverride);
+        _rig.AddString(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[4]);
         world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / net_v_scale);
     }
 
@@ -545,8 +1431,7 @@ void Renderer::DrawOneAugustoRacket(const glm::vec3 &_position, const glm::vec3
     // done separately because it has a different offset (for aesthetic purposes)
     world_transform_matrix = glm::translate(world_transform_matrix, net_first_h_translate);
     world_transform_matrix = glm::scale(world_transform_matrix, net_h_scale);
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[4] : _materialOverride);
+    _rig.AddString(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[4]);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / net_h_scale);
 
     // the rest of the net parts
@@ -554,8 +1439,7 @@ void Renderer::DrawOneAugustoRacket(const glm::vec3 &_position, const glm::vec3
     {
         world_transform_matrix = glm::translate(world_transform_matrix, net_h_translate);
         world_transform_matrix = glm::scale(world_transform_matrix, net_h_scale);
-        augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                       nullptr ? &augusto_racket_materials[4] : _materialOverride);
+        _rig.AddString(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[4]);
         world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / net_h_scale);
     }
 
@@ -564,111 +1448,97 @@ void Renderer::DrawOneAugustoRacket(const glm::vec3 &_position, const glm::vec3
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-full_v_translate.x, horizontal_bottom_scale.y, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 150.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 2.0f, 0.5f));
-    augusto_racket_cube->DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride ==
-                                                                                                                   nullptr ? &augusto_racket_materials[2] : _materialOverride);
+    _rig.AddPart(augusto_racket_cube.get(), world_transform_matrix, &augusto_racket_materials[2]);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.5f, 2.0f));
 }
 
-void Renderer::DrawOneGabrielleRacket(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride)
+void Renderer::BuildGabrielleRacketRig(RacketRig &_rig)
 {
+    // the racket's own transform is only known per frame, so every part is relative to it
     glm::mat4 world_transform_matrix = glm::mat4(1.0f);
-    // global transforms
-    world_transform_matrix = glm::translate(world_transform_matrix, _position);
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, _rotation);
-    world_transform_matrix = glm::scale(world_transform_matrix, _scale);
 
     // draw letter G //
     glm::mat4 secondary_transform_matrix = world_transform_matrix;
-    DrawOneG(secondary_transform_matrix, _viewProjection, _eyePosition, _materialOverride);
+    BuildOneG(_rig, secondary_transform_matrix);
 
     // tennis ball
     glm::mat4 third_transform_matrix = world_transform_matrix;
     third_transform_matrix = glm::translate(third_transform_matrix, glm::vec3(2.0f, 15.0f, 2.0f));
-    tennis_balls[1].DrawFromMatrix(_viewProjection, _eyePosition, third_transform_matrix, racket_render_mode, _materialOverride);
+    _rig.AddPart(&tennis_balls[1], third_transform_matrix);
 
     // arm //
-    gabrielle_racket_cube.material.color = glm::vec3(0.871f, 0.722f, 0.529f); // skin colour
+    const Shader::Material *part_material = &gabrielle_racket_materials[0]; // skin colour
 
     // forearm (skin)
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(45.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 5.0f, 1.0f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 0.2f, 1.0f));
 
     // arm (skin)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 5.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, rackets[1].upper_arm_rot);
+    world_transform_matrix = _rig.BeginElbow(world_transform_matrix); // the upper arm's rotation is applied here, once per frame
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 4.0f, 1.0f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 0.25f, 1.0f));
 
     // racket //
-    gabrielle_racket_cube.material.color = glm::vec3(1.0f, 0.714f, 0.757f); // pink colour
+    part_material = &gabrielle_racket_materials[1]; // pink colour
 
     // racket handle
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 4.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 4.0f, 0.5f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.25f, 2.0f));
 
     // racket angled bottom left
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 4.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(-60.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 2.5f, 0.5f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.4f, 2.0f));
 
     // racket vertical left
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 2.5f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(60.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 2.5f, 0.5f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1 / 2.5f, 2.0f));
 
     // racket angle top left
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 2.5f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(40.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 1.5f, 0.5f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1 / 1.5f, 2.0f));
 
     // racket horizontal top
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.5f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(50.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 2.0f, 0.5f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.5f, 2.0f));
 
     // racket angle top right
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 2.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(50.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 1.5f, 0.5f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1 / 1.5f, 2.0f));
 
     // racket vertical right
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.5f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(40.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 2.5f, 0.5f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1 / 2.5f, 2.0f));
 
     // racket horizontal bottom
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 2.5f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(90.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 4.0f, 0.5f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 1 / 4.0f, 2.0f));
 
     // racket angled bottom right
@@ -677,19 +1547,17 @@ void Renderer::DrawOneGabrielleRacket(const glm::vec3 &_position, const glm::vec
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 2.5f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(-60.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 2.25f, 0.5f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddPart(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1 / 0.5f, 1 / 2.25f, 1 / 0.5f));
 
     // net //
-    gabrielle_racket_cube.material.color = glm::vec3(1.0f, 1.0f, 1.0f); // white net colour
+    part_material = &gabrielle_racket_materials[2]; // white net colour
 
     // setup for nets horizontal
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.75f, 5.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(30.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.1f, 2.5f, 0.1f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddString(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1 / 0.1f, 1 / 2.5f, 1 / 0.1f));
 
     for (float j = 0; j < 6; j++)
@@ -697,8 +1565,7 @@ void Renderer::DrawOneGabrielleRacket(const glm::vec3 &_position, const glm::vec
         world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -0.5f));
         world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 0.0f));
         world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.1f, 3.5f, 0.1f));
-        gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                             racket_render_mode, _materialOverride);
+        _rig.AddString(&gabrielle_racket_cube, world_transform_matrix, part_material);
         world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1 / 0.1f, 1 / 3.5f, 1 / 0.1f));
     }
 
@@ -706,8 +1573,7 @@ void Renderer::DrawOneGabrielleRacket(const glm::vec3 &_position, const glm::vec
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -0.5f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(-90.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.1f, 3.5f, 0.1f));
-    gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                         racket_render_mode, _materialOverride);
+    _rig.AddString(&gabrielle_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1 / 0.1f, 1 / 3.5f, 1 / 0.1f));
 
     for (float j = 0; j < 6; j++)
@@ -715,93 +1581,76 @@ void Renderer::DrawOneGabrielleRacket(const glm::vec3 &_position, const glm::vec
         world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -0.5f));
         world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 0.0f));
         world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.1f, 3.5f, 0.1f));
-        gabrielle_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                             racket_render_mode, _materialOverride);
+        _rig.AddString(&gabrielle_racket_cube, world_transform_matrix, part_material);
         world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1 / 0.1f, 1 / 3.5f, 1 / 0.1f));
     }
 }
 
-void Renderer::DrawOneJackRacket(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection, const glm::vec3& _eyePosition, const Shader::Material *_materialOverride)
+void Renderer::BuildJackRacketRig(RacketRig &_rig)
 {
+    // the racket's own transform is only known per frame, so every part is relative to it
     glm::mat4 world_transform_matrix = glm::mat4(1.0f);
 
-    // 1.000f, 0.894f, 0.769f
-    // global transforms
-    // his position is my xyz in vec
-    // his rotation for me is a y vector
-    // his scale is like mine
-
-    world_transform_matrix = glm::translate(world_transform_matrix, _position);
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, _rotation);
-    world_transform_matrix = glm::scale(world_transform_matrix, _scale);
-
     // draw letter J //
     glm::mat4 secondary_transform_matrix = world_transform_matrix;
-    DrawOneJ(secondary_transform_matrix, _viewProjection, _eyePosition, _materialOverride);
+    BuildOneJ(_rig, secondary_transform_matrix);
 
     // tennis ball
     glm::mat4 third_transform_matrix = world_transform_matrix;
     third_transform_matrix = glm::translate(third_transform_matrix, glm::vec3(2.0f, 15.0f, 2.0f));
-    tennis_balls[2].DrawFromMatrix(_viewProjection, _eyePosition, third_transform_matrix, racket_render_mode, _materialOverride);
+    _rig.AddPart(&tennis_balls[2], third_transform_matrix);
 
-    jack_racket_cube.material.color = glm::vec3(1.000f, 0.894f, 0.769f); // skin colour
+    const Shader::Material *part_material = &jack_racket_materials[0]; // skin colour
 
     // forearm (skin)
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(45.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 5.0f, 1.0f));
-    jack_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                    racket_render_mode, _materialOverride);
+    _rig.AddPart(&jack_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 0.2f, 1.0f));
 
     // arm (skin)
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 5.0f, 0.0f));
-    world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, rackets[2].upper_arm_rot);
+    world_transform_matrix = _rig.BeginElbow(world_transform_matrix); // the upper arm's rotation is applied here, once per frame
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 4.0f, 1.0f));
-    jack_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                    racket_render_mode, _materialOverride);
+    _rig.AddPart(&jack_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(1.0f, 0.25f, 1.0f));
 
     // racket //
-    jack_racket_cube.material.color = glm::vec3(0.0f, 0.5f, 0.5f); // colour
+    part_material = &jack_racket_materials[1]; // colour
 
     // racket handle
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 4.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(0.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 5.0f, 0.5f));
-    jack_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                    racket_render_mode, _materialOverride);
+    _rig.AddPart(&jack_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.20f, 2.0f));
 
     // base
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 5.0f, -2.5f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(-90.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 5.0f, 0.5f));
-    jack_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                    racket_render_mode, _materialOverride);
+    _rig.AddPart(&jack_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, 0.20f, 2.0f));
 
     // left side
     // world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 5.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(90.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 7.0f, 0.5f));
-    jack_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                    racket_render_mode, _materialOverride);
+    _rig.AddPart(&jack_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, (1.0f / 7.0f), 2.0f));
 
     // top side
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 7.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(-90.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 5.0f, 0.5f));
-    jack_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                    racket_render_mode, _materialOverride);
+    _rig.AddPart(&jack_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, (1.0f / 5.0f), 2.0f));
 
     // Right side
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 5.0f, 0.0f));
     world_transform_matrix = Transforms::RotateDegrees(world_transform_matrix, glm::vec3(-90.0f, 0.0f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.5f, 7.0f, 0.5f));
-    jack_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix,
-                                    racket_render_mode, _materialOverride);
+    _rig.AddPart(&jack_racket_cube, world_transform_matrix, part_material);
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(2.0f, (1.0f / 7.0f), 2.0f));
 
     // setup for nets
@@ -809,7 +1658,7 @@ void Renderer::DrawOneJackRacket(const glm::vec3 &_position, const glm::vec3 &_r
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.2f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.1f, 4.5f, 0.1f));
 
-    jack_racket_cube.material.color = glm::vec3(1.0f, 1.0f, 1.0f); // colour
+    part_material = &jack_racket_materials[2]; // colour
 
     //||||||||||||||||||||||||
     float j;
@@ -819,7 +1668,7 @@ void Renderer::DrawOneJackRacket(const glm::vec3 &_position, const glm::vec3 &_r
         world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(10.0f, 1.0f / 4.5f, 10.0f));
         world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -0.5f));
         world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.1f, 4.5f, 0.1f));
-        jack_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride);
+        _rig.AddString(&jack_racket_cube, world_transform_matrix, part_material);
     }
 
     //-------------------------
@@ -835,13 +1684,16 @@ void Renderer::DrawOneJackRacket(const glm::vec3 &_position, const glm::vec3 &_r
         world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(10.0f, 1.0f / 6.5f, 10.0f));
         world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -0.5f));
         world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(0.1f, 6.5f, 0.1f));
-        jack_racket_cube.DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, racket_render_mode, _materialOverride);
+        _rig.AddString(&jack_racket_cube, world_transform_matrix, part_material);
     }
 }
 
 // augusto letter A
-void Renderer::DrawOneA(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride)
+void Renderer::BuildOneA(RacketRig &_rig, glm::mat4 world_transform_matrix)
 {
+    // the letter's cubes never move relative to each other, so they are baked into a single model
+    std::vector<glm::mat4> part_transforms;
+
     auto scale_factor = glm::vec3(0.75f, 0.75f, 0.75f); // scale for one cube
 
     // base transform
@@ -851,113 +1703,123 @@ void Renderer::DrawOneA(glm::mat4 world_transform_matrix, const glm::mat4& _view
     world_transform_matrix = glm::scale(world_transform_matrix, glm::vec3(scale_factor));
 
     // long left A vertical cubes
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     // short top A horizontal cubes
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(1.0f, 1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(1.0f, 0.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     // long right A vertical cubes
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(1.0f, -1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, -1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, -1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, -1.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     // short middle A horizontal cubes
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-1.0f, 2.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(-1.0f, 0.0f, 0.0f));
-    letter_cubes[0].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
+
+    letter_models.push_back(std::make_unique<VisualBakedModel>(*letter_cubes[0].GetMesh(), part_transforms, letter_cubes[0].material));
+    _rig.AddPart(letter_models.back().get(), glm::mat4(1.0f), nullptr, false);
 }
 
 // gabrielle letter G
-void Renderer::DrawOneG(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride)
+void Renderer::BuildOneG(RacketRig &_rig, glm::mat4 world_transform_matrix)
 {
-    auto scale_factor = glm::vec3(0.75f, 0.75f, 0.75f);               // scale for one cube
-    letter_cubes[1].material.color = glm::vec3(1.0f, 0.714f, 0.757f); // white net colour
+    // the letter's cubes never move relative to each other, so they are baked into a single model
+    std::vector<glm::mat4> part_transforms;
+
+    auto scale_factor = glm::vec3(0.75f, 0.75f, 0.75f); // scale for one cube
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 20.0f, -3.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, 0.75f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.75f, 0.75f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.75f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.75f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.75f, -0.75f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -0.75f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -0.75f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 2 * -0.75f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, 0.75f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, -0.75f, -0.75f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[1].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+
+    letter_models.push_back(std::make_unique<VisualBakedModel>(*letter_cubes[1].GetMesh(), part_transforms, letter_cubes[1].material));
+    _rig.AddPart(letter_models.back().get(), glm::mat4(1.0f), nullptr, false);
 }
 
 // jack letter J
-void Renderer::DrawOneJ(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride)
+void Renderer::BuildOneJ(RacketRig &_rig, glm::mat4 world_transform_matrix)
 {
-    auto scale_factor = glm::vec3(0.75f, 0.75f, 0.75f);               // scale for one cube
-    letter_cubes[2].material.color = glm::vec3(1.0f, 0.714f, 0.757f); // white net colour
+    // the letter's cubes never move relative to each other, so they are baked into a single model
+    std::vector<glm::mat4> part_transforms;
+
+    auto scale_factor = glm::vec3(0.75f, 0.75f, 0.75f); // scale for one cube
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 23.0f, -3.0f)); // go up and center
 
@@ -966,48 +1828,119 @@ void Renderer::DrawOneJ(glm::mat4 world_transform_matrix, const glm::mat4& _view
     // hence same scaling and jump of position
 
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[2].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, 0.75f)); // 1 block to the left
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[2].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.75f, 0.75f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[2].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -1.5f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[2].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.75f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[2].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.75f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[2].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.75f, 0.0f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[2].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, 0.75f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[2].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
 
     world_transform_matrix = glm::translate(world_transform_matrix, glm::vec3(0.0f, 0.0f, -1.50f));
     world_transform_matrix = glm::scale(world_transform_matrix, scale_factor);
-    letter_cubes[2].DrawFromMatrix(_viewProjection, _eyePosition, world_transform_matrix, GL_TRIANGLES, _materialOverride);
+    part_transforms.push_back(world_transform_matrix);
     world_transform_matrix = glm::scale(world_transform_matrix, 1.0f / scale_factor);
+
+    letter_models.push_back(std::make_unique<VisualBakedModel>(*letter_cubes[2].GetMesh(), part_transforms, letter_cubes[2].material));
+    _rig.AddPart(letter_models.back().get(), glm::mat4(1.0f), nullptr, false);
+}
+
+void Renderer::PrintFrameStats() const
+{
+    std::cout << "INFO -> Draw calls: " << frame_stats.shadow_draw_calls << " (shadow pass) + " << frame_stats.depth_prepass_draw_calls << " (depth prepass) + "
+              << frame_stats.color_draw_calls << " (color pass) = " << frame_stats.shadow_draw_calls + frame_stats.depth_prepass_draw_calls + frame_stats.color_draw_calls << std::endl;
+
+    const auto &queue_stats = render_queue->stats;
+    std::cout << "INFO -> Render queue: " << queue_stats.packets << " packets, " << queue_stats.program_changes << " program changes, "
+              << queue_stats.texture_changes << " texture changes, " << queue_stats.vertex_array_changes << " vertex array changes" << std::endl;
+
+    std::cout << "INFO -> Sphere draws per subdivision level (0 to " << VisualSphere::MAX_SUBDIVISIONS << "):";
+
+    for (const int lod_draw_calls : VisualSphere::lod_draw_calls)
+        std::cout << " " << lod_draw_calls;
+
+    std::cout << std::endl;
+
+    std::cout << "INFO -> Shadow maps: " << shadow_map_count << " x 2 layers x " << shadow_map_size << "x" << shadow_map_size << " = "
+              << 2 * shadow_map_count * shadow_map_size * shadow_map_size << " texels (" << (main_light->GetMode() == Light::Mode::SUN ? "sun cascades" : main_light->GetMode() == Light::Mode::POINT ? "point cube faces" : "perspective") << ")" << std::endl;
+
+    if (exponential_shadows)
+        std::cout << "INFO -> Shadow filter: exponential, blurred at " << exponential_map_size << "x" << exponential_map_size << " per shadow map" << std::endl;
+    else
+        std::cout << "INFO -> Shadow filter: " << SHADOW_FILTER_TAPS[shadow_filter] << (SHADOW_FILTER_TAPS[shadow_filter] == 16 ? " Poisson" : "") << " tap(s)" << std::endl;
+
+    std::cout << "INFO -> Shadow passes: " << shadow_cache.static_rendered_passes << " static & " << shadow_cache.dynamic_rendered_passes << " dynamic rendered, "
+              << shadow_cache.skipped_passes << " skipped (nothing changed), " << frame_stats.culled_shadow_casters << " caster(s) outside of the light's view culled" << std::endl;
+
+    std::cout << "INFO -> Camera culling: " << frame_stats.visible_objects << " object(s) visible, " << frame_stats.culled_objects << " culled (outside of the camera's view)" << std::endl;
+
+    std::cout << "INFO -> Occlusion culling (" << (occlusion_culling ? "on" : "off") << "): " << frame_stats.occlusion_queries << " racket box(es) tested, " << frame_stats.occluded_rackets << " racket(s) hidden & not drawn, "
+              << frame_stats.conditional_rackets << " drawn under conditional rendering (" << queue_stats.conditional_draws << " draws)" << std::endl;
+
+    const auto &occlusion_stats = occlusion_rasterizer->stats;
+    std::cout << "INFO -> Software occlusion (" << (software_occlusion ? "on" : "off") << "): " << occlusion_stats.rasterized_triangles << " of " << occlusion_stats.occluder_triangles << " occluder triangle(s) rasterized at "
+              << SoftwareOcclusion::WIDTH << "x" << SoftwareOcclusion::HEIGHT << " in " << occlusion_stats.rasterization_ms << " ms on " << occlusion_stats.rasterization_threads << " thread(s) ("
+              << occlusion_stats.parallel_rasterizations << " parallel rasterizations so far), " << occlusion_stats.tested_bounds << " object(s) tested, "
+              << frame_stats.software_occluded_objects << " hidden & not drawn" << std::endl;
+
+    const auto &scene_stats = scene_bvh->stats;
+    std::cout << "INFO -> Scene BVH: " << scene_stats.proxies << " renderables, height " << scene_stats.height << ", SAH cost at " << scene_stats.cost_ratio << "x the last rebuild's ("
+              << scene_stats.rebuilds << " rebuilds), " << scene_stats.reinserted_proxies << " reinserted & " << scene_stats.visited_nodes << " nodes visited by " << scene_stats.queries << " queries" << std::endl;
+
+    std::cout << "INFO -> Racket pose evaluation: " << frame_stats.pose_evaluation_ms << " ms" << std::endl;
+
+    const auto &light_stats = clustered_lights->stats;
+    std::cout << "INFO -> Point lights: " << light_stats.lights << " in " << ClusteredLights::CLUSTER_COUNT << " clusters, " << light_stats.light_indices << " light indices ("
+              << light_stats.dropped_light_indices << " dropped), at most " << light_stats.max_cluster_lights << " per cluster, binned in " << light_stats.binning_ms << " ms" << std::endl;
+
+    const auto &atlas_stats = shadow_atlas->stats;
+    std::cout << "INFO -> Shadow atlas: " << atlas_stats.shadowed_lights << " point light(s) shadowed (" << atlas_stats.dropped_lights << " dropped), " << atlas_stats.tiles << " tiles, "
+              << atlas_stats.updated_tiles << " rendered this frame (budget of " << shadow_atlas->update_budget << "), " << atlas_stats.pending_tiles << " never rendered, " << atlas_stats.stale_tiles << " stale (a racket moved in them), "
+              << atlas_stats.replaced_sets << " sets kept until their replacement is rendered, " << atlas_stats.allocated_sets << " sets allocated (" << atlas_stats.failed_allocations << " failed), "
+              << queue_stats.skipped_packets << " caster draws skipped (outside of their tile)" << std::endl;
+
+    std::cout << "INFO -> Frame: " << frame_stats.render_ms << " ms on the CPU" << std::endl;
+
+    // overdraw is how many times each pixel was shaded on average, 1.0 meaning that no fragment was shaded for nothing
+    // query results lag a couple of frames behind, which doesn't matter for a static view
+    const auto shaded_samples = color_pass_samples_query->GetResult();
+    const auto color_pass_ms = (double)color_pass_time_query->GetResult() / 1000000.0;
+    const auto pixel_count = (double)viewport_width * viewport_height;
+
+    std::cout << "INFO -> Color pass (" << viewport_width << "x" << viewport_height << ", depth prepass " << (depth_prepass ? "on" : "off") << "): "
+              << color_pass_ms << " ms on the GPU, " << shaded_samples << " shaded samples, " << (double)shaded_samples / pixel_count << "x overdraw" << std::endl;
+
+    std::cout << "INFO -> GL state calls: " << GLStateCache::stats.issued << " issued, " << GLStateCache::stats.elided << " elided" << std::endl;
 }
 
 void Renderer::ResizeCallback(GLFWwindow *_window, int _displayWidth, int _displayHeight)
@@ -1027,7 +1960,7 @@ GLuint Renderer::LoadTexture(const char *filename)
   assert(textureId != 0);
 
 
-  glBindTexture(GL_TEXTURE_2D, textureId);
+  GLStateCache::BindTexture(0, GL_TEXTURE_2D, textureId);
 
   // Step2 Set filter parameters
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -1055,7 +1988,7 @@ GLuint Renderer::LoadTexture(const char *filename)
 
   // Step5 Free resources
   stbi_image_free(data);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  GLStateCache::BindTexture(0, GL_TEXTURE_2D, 0);
   return textureId;
 }
 
@@ -1228,6 +2161,99 @@ void Renderer::InputCallback(GLFWwindow *_window, const double _deltaTime)
         main_camera->SetDefaultPositionAndTarget();
     }
 
+    // prints the last frame's statistics
+    if (Input::IsKeyReleased(_window, GLFW_KEY_I))
+    {
+        PrintFrameStats();
+    }
+
+    // cycles the light through its point (cube shadow map), perspective & sun (cascaded shadow maps) modes
+    if (Input::IsKeyReleased(_window, GLFW_KEY_M))
+    {
+        switch (main_light->GetMode()) {
+            case Light::Mode::POINT:
+                main_light->SetMode(Light::Mode::PERSPECTIVE);
+                break;
+            case Light::Mode::PERSPECTIVE:
+                main_light->SetMode(Light::Mode::SUN);
+                break;
+            case Light::Mode::SUN:
+                main_light->SetMode(Light::Mode::POINT);
+                break;
+        }
+    }
+
+    // cycles through the shadow map resolutions (512, 1024, 2048 & 4096)
+    if (Input::IsKeyReleased(_window, GLFW_KEY_R))
+    {
+        const int base_size = main_light->GetBaseShadowMapSize();
+        main_light->SetShadowMapSize(base_size >= Light::MAX_SHADOW_MAP_SIZE ? Light::MIN_SHADOW_MAP_SIZE : base_size * 2);
+    }
+
+    // cycles through the shadow filtering kernels
+    if (Input::IsKeyReleased(_window, GLFW_KEY_F))
+    {
+        SetShadowFilter(shadow_filter + 1);
+    }
+
+    // toggles the exponential shadow maps
+    if (Input::IsKeyReleased(_window, GLFW_KEY_V))
+    {
+        SetExponentialShadows(!exponential_shadows);
+    }
+
+    // cycles the occlusion culling through GPU queries (rackets only), the CPU software rasterizer, both & none
+    if (Input::IsKeyReleased(_window, GLFW_KEY_SPACE))
+    {
+        const int occlusion_mode = (((software_occlusion ? 2 : 0) | (occlusion_culling ? 1 : 0)) + 1) % 4;
+
+        occlusion_culling = (occlusion_mode & 1) != 0;
+        software_occlusion = (occlusion_mode & 2) != 0;
+    }
+
+    // selects the racket under the cursor
+    if (Input::IsKeyReleased(_window, GLFW_KEY_ENTER))
+    {
+        PickRacket(_window);
+    }
+
+    // cycles through the shadow atlas' update budgets
+    if (Input::IsKeyReleased(_window, GLFW_KEY_C))
+    {
+        const auto current = std::find(SHADOW_ATLAS_BUDGETS.begin(), SHADOW_ATLAS_BUDGETS.end(), shadow_atlas->update_budget);
+        const auto next = current == SHADOW_ATLAS_BUDGETS.end() || current + 1 == SHADOW_ATLAS_BUDGETS.end() ? SHADOW_ATLAS_BUDGETS.begin() : current + 1;
+
+        shadow_atlas->update_budget = *next;
+    }
+
+    // cycles through the sun's cascade counts
+    if (Input::IsKeyReleased(_window, GLFW_KEY_N))
+    {
+        main_light->SetCascadeCount(main_light->GetCascadeCount() >= Light::MAX_CASCADES ? Light::MIN_CASCADES : main_light->GetCascadeCount() + 1);
+    }
+
+    // cycles through the point light counts
+    if (Input::IsKeyReleased(_window, GLFW_KEY_K))
+    {
+        const auto current = std::find(POINT_LIGHT_COUNTS.begin(), POINT_LIGHT_COUNTS.end(), (int)point_lights.size());
+        const auto next = current == POINT_LIGHT_COUNTS.end() || current + 1 == POINT_LIGHT_COUNTS.end() ? POINT_LIGHT_COUNTS.begin() : current + 1;
+
+        SetPointLightCount(*next);
+    }
+
+    // benchmarks the frame time against the point light count (printed along the way)
+    if (Input::IsKeyReleased(_window, GLFW_KEY_G) && !light_benchmark.running)
+    {
+        light_benchmark = {.running = true, .previous_light_count = point_lights.size()};
+        SetPointLightCount(LIGHT_BENCHMARK_COUNTS[0]);
+    }
+
+    // toggles the opaque depth prepass
+    if (Input::IsKeyReleased(_window, GLFW_KEY_O))
+    {
+        depth_prepass = !depth_prepass;
+    }
+
     // pauses camera movement
     if (Input::IsKeyReleased(_window, GLFW_KEY_Z))
     {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <optional>
 #include <utility>
 #include "Camera.h"
 #include "Shader.h"
@@ -11,7 +12,16 @@
 #include "Visual/VisualCube.h"
 #include "Visual/VisualSphere.h"
 #include "Visual/VisualPlane.h"
+#include "Visual/VisualBakedModel.h"
 #include "Screen.h"
+#include "FrameUniforms.h"
+#include "RenderQueue.h"
+#include "GLStateCache.h"
+#include "GLQuery.h"
+#include "ClusteredLights.h"
+#include "ShadowAtlas.h"
+#include "BoundingVolumeHierarchy.h"
+#include "SoftwareOcclusion.h"
 
 
 class Renderer
@@ -28,11 +38,218 @@ private:
 
         Racket() = default;
         Racket(glm::vec3 _position, glm::vec3 _rotation, glm::vec3 _scale) : position(_position), rotation(_rotation), scale(_scale) {}
+
+        bool operator==(const Racket &_other) const
+        {
+            return position == _other.position && rotation == _other.rotation && scale == _other.scale && upper_arm_rot == _other.upper_arm_rot;
+        }
+    };
+
+    struct RacketPart
+    {
+        VisualObject *object;
+        const Shader::Material *material; // nullptr to use the object's own material
+        glm::mat4 local_transform; // relative to the racket's root, or to its elbow when articulated
+
+        bool articulated; // whether it follows the upper arm's rotation
+        bool follows_render_mode; // letters are always drawn filled
+        bool string; // the strings are identical cubes of a same material, drawn together in a single instanced draw per pass
+    };
+
+    // Racket hierarchy, flattened at init so that only the racket's transform & upper arm rotation are applied per frame
+    struct RacketRig
+    {
+        std::vector<RacketPart> parts;
+        glm::mat4 elbow_transform = glm::mat4(1.0f); // relative to the racket's root, before the upper arm's rotation
+
+        std::vector<glm::mat4> world_transforms; // one per part, evaluated once per frame for both passes
+        Bounds world_bounds; // of every part, evaluated along with their world transforms
+        std::optional<Racket> evaluated_pose; // pose the world transforms were last evaluated for
+
+        void AddPart(VisualObject *_object, const glm::mat4 &_localTransform, const Shader::Material *_material = nullptr, bool _followsRenderMode = true)
+        {
+            parts.push_back({_object, _material, _localTransform, articulating, _followsRenderMode, false});
+        }
+
+        // every string of a racket has to be the same object, with the same material
+        void AddString(VisualObject *_object, const glm::mat4 &_localTransform, const Shader::Material *_material)
+        {
+            parts.push_back({_object, _material, _localTransform, articulating, true, true});
+        }
+
+        // every part added afterwards is relative to the elbow, which is where the upper arm's rotation is applied
+        glm::mat4 BeginElbow(const glm::mat4 &_transform)
+        {
+            elbow_transform = _transform;
+            articulating = true;
+
+            return glm::mat4(1.0f);
+        }
+
+    private:
+        bool articulating = false;
+    };
+
+    // Which of the scene's queries a renderable is found by
+    enum SceneMask : uint32_t
+    {
+        SCENE_VISIBLE = 1 << 0, // drawn by the color pass
+        SCENE_STATIC_SHADOW = 1 << 1, // drawn into the static shadow layers (receivers that don't cast included, since the light is fitted to them)
+        SCENE_DYNAMIC_SHADOW = 1 << 2,
+        SCENE_PICKABLE = 1 << 3,
     };
 
+    // Anything drawn by the color pass (except the world cube, which always surrounds the camera), indexed by the scene's BVH
+    struct Renderable
+    {
+        VisualObject *object;
+        const Shader::Material *material = nullptr; // nullptr to use the object's own material
+        glm::mat4 transform = glm::mat4(1.0f);
+        int render_mode = GL_TRIANGLES; // RACKET_RENDER_MODE for racket parts that follow the rackets' render mode
+        uint32_t scene_mask = SCENE_VISIBLE;
+        int racket = -1; // the racket it is a part of, if any
+        bool string = false; // one of its racket's strings, only pushed along with the others (see RacketPart::string)
+
+        int proxy = BoundingVolumeHierarchy::NULL_NODE;
+    };
+
+    // Whether a racket (letters included) is hidden, tested by drawing its bounding box under an occlusion query once the color pass is done
+    // Results are only used the frame after, so that the GPU is never waited on: a racket whose last result is known to be 0 isn't drawn at all,
+    // and one whose result isn't back yet is left to conditional rendering
+    struct RacketOcclusion
+    {
+        std::unique_ptr<GLQuery> query; // GL_ANY_SAMPLES_PASSED
+        bool tested_last_frame = false; // otherwise, the query's last result is stale
+
+        // this frame's decision
+        bool in_view = false; // any of its parts is inside of the camera's view
+        bool tested = false; // its box is drawn under the query this frame
+        bool hidden = false; // not drawn at all
+        GLuint condition_query = 0; // drawn under conditional rendering of this query, 0 to always draw it
+    };
+
+    // The shadow maps are kept from a frame to the next, and only re-rendered when the light or one of the casters changed
+    // Each shadow map has a layer for the casters that never move (the net) and one for those that do (the rackets),
+    // so that moving rackets only re-render the latter
+    struct ShadowCache
+    {
+        // also set when the shadow maps' contents are lost (e.g. reallocated)
+        bool static_dirty = true;
+        bool dynamic_dirty = true;
+
+        // caster state that isn't a transform
+        int racket_render_mode = -1;
+        bool shadow_mode = false;
+        bool exponential_shadows = false; // the exponential maps are only filtered along with the layers, so they're stale once re-enabled
+
+        // the light is fitted to the static casters, only grown when dynamic ones leave them, so that moving rackets rarely move the light
+        Bounds fitted_bounds;
+
+        // since startup (for profiling purposes)
+        int static_rendered_passes = 0;
+        int dynamic_rendered_passes = 0;
+        int skipped_passes = 0;
+    };
+
+    // Counters of the last rendered frame (for profiling purposes)
+    struct FrameStats
+    {
+        int shadow_draw_calls = 0;
+        int depth_prepass_draw_calls = 0;
+        int color_draw_calls = 0;
+        int culled_shadow_casters = 0; // outside of every shadow map of the light
+        int visible_objects = 0; // color pass packets inside the camera's view
+        int culled_objects = 0; // renderables outside of it, never drawn
+        int occlusion_queries = 0;
+        int occluded_rackets = 0; // hidden last frame, so not drawn at all
+        int conditional_rackets = 0; // whose last result wasn't back yet, drawn under conditional rendering
+        int software_occluded_objects = 0; // in the camera's view, but behind the CPU-rasterized occluders, so never pushed
+
+        double pose_evaluation_ms = 0.0;
+        double render_ms = 0.0; // CPU time of the whole frame, up to (but excluding) the buffer swap
+    };
+
+    // Measures the cost of the point lights by stepping through LIGHT_BENCHMARK_COUNTS, a few frames each
+    // CPU & GPU times are measured separately, since the frame rate itself is capped by vsync
+    struct LightBenchmark
+    {
+        bool running = false;
+        size_t step = 0;
+        int frame = 0;
+        size_t previous_light_count = 0; // restored once done
+
+        // summed over the measured frames of the current step
+        double render_ms = 0.0;
+        double binning_ms = 0.0;
+        double color_pass_ms = 0.0;
+    };
+
+    // shadow filtering kernels, in taps of the (already 2x2 filtered) shadow map, the last one being a Poisson disk
+    inline constexpr static std::array<int, 4> SHADOW_FILTER_TAPS = {1, 4, 9, 16};
+
+    // exponential shadow maps are blurred once after the shadow passes, at a lower resolution, instead of being filtered by every fragment
+    inline constexpr static int ESM_DOWNSAMPLE = 2; // has to match the shaders' ESM_DOWNSAMPLE
+    inline constexpr static int EXPONENTIAL_SHADOWS_UNIT = 5; // right after the point lights' buffer textures
+
+    // point light counts, cycled through at runtime & benchmarked
+    inline constexpr static std::array<int, 4> POINT_LIGHT_COUNTS = {0, 64, 256, 1024};
+    inline constexpr static std::array<int, 8> LIGHT_BENCHMARK_COUNTS = {0, 16, 64, 128, 256, 512, 1024, 2048};
+    inline constexpr static int LIGHT_BENCHMARK_WARMUP_FRAMES = 10; // lets the GPU queries, which lag behind, catch up with a new light count
+    inline constexpr static int LIGHT_BENCHMARK_FRAMES = 120;
+
+    inline constexpr static int RACKET_RENDER_MODE = -1;
+
+    // occlusion boxes are grown past their racket, so that its own faces never hide them & the camera's near plane never cuts into them unnoticed
+    inline constexpr static float OCCLUSION_BOX_MARGIN = 0.1f;
+
+    // added to the level of detail spheres pick from their projected radius (in levels), shadows being blurry enough to do with coarser ones
+    inline constexpr static float SPHERE_LOD_BIAS = 0.0f;
+    inline constexpr static float SHADOW_SPHERE_LOD_BIAS = -1.0f;
+
+    // shadow atlas tiles re-rendered per frame, cycled through at runtime (a light has 6 tiles, 96 being every tile of every shadowed light)
+    inline constexpr static std::array<int, 4> SHADOW_ATLAS_BUDGETS = {1, 6, 24, 96};
+
     std::unique_ptr<Screen> main_screen;
     std::shared_ptr<Camera> main_camera;
-    std::unique_ptr<Shader::Material> shadow_mapper_material;
+    // shadow casters go through a layered geometry shader, which only takes one kind of primitive, so there is one per kind
+    std::map<int, Shader::Material> shadow_mapper_materials; // keyed by GL_TRIANGLES, GL_LINES & GL_POINTS
+
+    // every lit material shares this shader, whose program is swapped for the variant of the current shadow filter
+    std::shared_ptr<Shader> lit_shader;
+    std::array<std::shared_ptr<Shader>, SHADOW_FILTER_TAPS.size()> lit_shadow_filter_variants;
+    std::shared_ptr<Shader> lit_exponential_variant; // looks shadows up in the exponential maps, whatever the shadow filter
+    size_t shadow_filter = 1;
+    bool exponential_shadows = false;
+
+    // fullscreen passes of the separable blur, the horizontal one also turning the shadow maps' depths into exponential occluders
+    Shader::Material exponential_horizontal_blur_material;
+    Shader::Material exponential_vertical_blur_material;
+    std::unique_ptr<Shader::Material> depth_prepass_material;
+    std::unique_ptr<FrameUniforms> frame_uniforms;
+    std::unique_ptr<RenderQueue> render_queue;
+
+    // stadium floodlights, binned into clusters every frame so that the lit shader only loops over those that reach each fragment
+    std::unique_ptr<ClusteredLights> clustered_lights;
+    std::vector<ClusteredLights::PointLight> point_lights;
+    std::unique_ptr<ShadowAtlas> shadow_atlas; // shadows of the point lights that matter the most
+
+    // GPU-side measurements of the color pass, to compare fill rate with & without the depth prepass
+    std::unique_ptr<GLQuery> color_pass_time_query; // whole color pass, including the depth prepass
+    std::unique_ptr<GLQuery> color_pass_samples_query; // samples that passed the depth test, i.e. that were shaded
+
+    // every renderable's world box, so that culling, shadow caster selection & picking don't go through the whole scene
+    std::unique_ptr<BoundingVolumeHierarchy> scene_bvh;
+    std::vector<Renderable> renderables; // indexed by their proxies' user data
+    std::vector<std::vector<size_t>> racket_renderables; // per racket, one per part of its rig
+    size_t main_light_cube_renderable = 0;
+    std::vector<uint32_t> scene_query_results;
+    std::vector<std::vector<size_t>> racket_string_batches; // per racket, the strings found by the scene query being pushed
+    std::vector<glm::mat4> string_transforms;
+
+    std::vector<RacketOcclusion> racket_occlusions; // one per racket
+    std::unique_ptr<VisualCube> occlusion_box; // unit box, drawn depth-only
+
+    std::unique_ptr<SoftwareOcclusion> occlusion_rasterizer; // the ground, the net's posts & the world cube, rasterized on the CPU
 
     std::unique_ptr<VisualGrid> main_grid;
 
@@ -48,28 +265,50 @@ private:
     std::vector<VisualSphere> tennis_balls;
 
     std::vector<VisualCube> net_cubes;
+    std::vector<std::unique_ptr<VisualBakedModel>> net_models; // posts & strands
+    std::vector<glm::mat4> net_post_transforms; // of net_cubes[0], also used as occluders
 
     std::vector<VisualCube> letter_cubes;
+    std::vector<std::unique_ptr<VisualBakedModel>> letter_models;
 
     std::shared_ptr<VisualCube> augusto_racket_cube;
     std::vector<Shader::Material> augusto_racket_materials;
 
     VisualCube gabrielle_racket_cube;
+    std::vector<Shader::Material> gabrielle_racket_materials;
+
     VisualCube jack_racket_cube;
+    std::vector<Shader::Material> jack_racket_materials;
 
     std::vector<Racket> rackets;
     std::vector<Racket> default_rackets;
+    std::vector<RacketRig> racket_rigs;
 
     int viewport_width, viewport_height;
 
     bool shadow_mode = true;
+    bool depth_prepass = true; // opaque geometry is drawn into depth first, so that only visible fragments are shaded
+    bool occlusion_culling = true; // rackets hidden last frame are skipped
+    bool software_occlusion = false; // objects behind the CPU-rasterized occluders are skipped
     bool texture_mode = true;
     bool light_movement = true;
     int racket_render_mode = GL_TRIANGLES;
     int selected_player = 4;
 
     GLuint shadow_map_fbo = 0;
-    GLuint shadow_map_depth_tex = 0;
+    GLuint shadow_map_depth_tex = 0; // texture array, with the static layer of every shadow map of the light, then their dynamic layer
+    int shadow_map_size = 0;
+    int shadow_map_count = 0;
+
+    GLuint exponential_shadows_fbo = 0;
+    GLuint exponential_shadows_tex = 0; // texture array, with the blurred exponential map of every shadow map (both layers combined)
+    GLuint exponential_blur_tex = 0; // horizontal blur's result, reused by every shadow map
+    GLuint depth_read_sampler = 0; // reads the shadow maps' depths as they are, since their texture compares them when sampled
+    int exponential_map_size = 0;
+
+    ShadowCache shadow_cache;
+    FrameStats frame_stats;
+    LightBenchmark light_benchmark;
 
 public:
     Renderer(int _initialWidth, int _initialHeight);
@@ -77,14 +316,47 @@ public:
     void Init();
     void Render(GLFWwindow *_window, double _deltaTime);
 
-    void DrawOneNet(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection, const glm::vec3& _eyePosition, const Shader::Material *_materialOverride = nullptr);
-    void DrawOneAugustoRacket(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride = nullptr);
-    void DrawOneGabrielleRacket(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride = nullptr);
-    void DrawOneJackRacket(const glm::vec3 &_position, const glm::vec3 &_rotation, const glm::vec3 &_scale, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride = nullptr);
+    void SetShadowFilter(size_t _filter); // index into SHADOW_FILTER_TAPS
+    void SetExponentialShadows(bool _enabled); // replaces the shadow filter while enabled
+    void AllocateShadowMaps(); // (re)allocates the shadow map depth texture for the light's current shadow map count & size
+    void RenderShadowLayers(RenderQueue::Pass _pass, int _firstLayer); // draws a shadow pass' casters into every shadow map at once, from the given layer on
+    void FilterExponentialShadows(); // turns every shadow map into its blurred exponential map, to be called once their layers are rendered
+    void RenderShadowAtlas(FrameUniforms::Data _frameData); // draws this frame's scheduled atlas tiles, each as a single shadow map
+    [[nodiscard]] const Shader::Material *GetShadowMapperMaterial(int _renderMode) const;
+
+    void SetPointLightCount(size_t _count); // the same floodlights are always laid out first, so that counts can be compared
+    void UpdateLightBenchmark(); // to be called at the end of every frame
+
+    void BuildScene(); // registers every renderable into the scene's BVH, once every object & racket rig is built
+    size_t AddRenderable(const Renderable &_renderable);
+    void MoveRenderable(size_t _index, const glm::mat4 &_transformMatrix);
+    [[nodiscard]] int GetRenderMode(const Renderable &_renderable) const;
+    void PickRacket(GLFWwindow *_window); // selects the racket under the cursor
+
+    void UpdateRacketOcclusions(); // decides how each racket in view is drawn from its last occlusion query, to be called before its parts are pushed
+    void RenderOcclusionQueries(); // draws the boxes of the rackets tested this frame, to be called once the color pass filled the depth buffer
+    [[nodiscard]] glm::mat4 GetOcclusionBoxTransform(const Bounds &_bounds) const;
+
+    void CollectShadowCasters(RenderQueue::Pass _pass); // pushes the static, dynamic or atlas (all) shadow casters the BVH finds in their pass' view, if shadows are enabled
+    [[nodiscard]] Bounds GetShadowCasterBounds(uint32_t _sceneMask) const; // of every renderable of a shadow pass (casting or not), to fit the light to
+
+    void PushShadowCaster(VisualObject *_object, const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material); // with the shadow mapper of its primitives, unless its material doesn't cast
+    void PushRacketStrings(bool _shadowCasters); // each racket's batched strings as a single instanced draw, then empties the batches
+    int CullShadowCasters(); // drops the casters outside of every shadow map of the light, returns how many were
+
+    void BakeNet();
+
+    bool EvaluateRacketPoses(); // moves the parts of the rackets that moved since their last evaluation, returns whether any did
+
+    void BuildAugustoRacketRig(RacketRig &_rig);
+    void BuildGabrielleRacketRig(RacketRig &_rig);
+    void BuildJackRacketRig(RacketRig &_rig);
+
+    void BuildOneA(RacketRig &_rig, glm::mat4 world_transform_matrix);
+    void BuildOneG(RacketRig &_rig, glm::mat4 world_transform_matrix);
+    void BuildOneJ(RacketRig &_rig, glm::mat4 world_transform_matrix);
 
-    void DrawOneA(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride = nullptr);
-    void DrawOneG(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride = nullptr);
-    void DrawOneJ(glm::mat4 world_transform_matrix, const glm::mat4& _viewProjection,const glm::vec3& _eyePosition, const Shader::Material *_materialOverride = nullptr);
+    void PrintFrameStats() const;
 
     void ResizeCallback(GLFWwindow *_window, int _displayWidth, int _displayHeight);
     void InputCallback(GLFWwindow *_window, double _deltaTime);
@@ -2,6 +2,7 @@
 
 #include <utility>
 #include "Utility/Transform.hpp"
+#include "GLStateCache.h"
 
 Screen::Screen(Shader::Material _material) : VisualObject(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), std::move(_material))
 {
@@ -21,20 +22,20 @@ Screen::Screen(Shader::Material _material) : VisualObject(glm::vec3(0.0f), glm::
     VisualObject::SetupGlBuffersVerticesAndUvsOnly();
 }
 
-void Screen::Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode, const Shader::Material *material)
+void Screen::Draw(int _renderMode, const Shader::Material *material)
 {
     glm::mat4 model_matrix = glm::mat4(1.0f);
     model_matrix = glm::translate(model_matrix, position);
     model_matrix = Transforms::RotateDegrees(model_matrix, rotation);
     model_matrix = glm::scale(model_matrix, scale);
 
-    DrawFromMatrix(_viewProjection, _cameraPosition, model_matrix, _renderMode, material);
+    DrawFromMatrix(model_matrix, _renderMode, material);
 }
 
-void Screen::DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
+void Screen::DrawFromMatrix(const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
 {
     // bind the vertex array to draw
-    glBindVertexArray(vertex_array_o);
+    GLStateCache::BindVertexArray(vertex_array_o);
 
     const Shader::Material *current_material = &material;
 
@@ -47,11 +48,11 @@ void Screen::DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_
     current_material->shader->SetVec3("u_color", current_material->color);
     current_material->shader->SetFloat("u_alpha", current_material->alpha);
 
-    current_material->shader->SetTexture("u_texture", 0);
-
-    glLineWidth(current_material->line_thickness);
-    glPointSize(current_material->point_size);
+    GLStateCache::LineWidth(current_material->line_thickness);
+    GLStateCache::PointSize(current_material->point_size);
 
     // draw vertices according to their indices
     glDrawElements(_renderMode, indices.size(), GL_UNSIGNED_INT, nullptr);
+
+    ++draw_calls;
 }
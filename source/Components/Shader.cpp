@@ -1,4 +1,9 @@
 #include "Shader.h"
+#include "FrameUniforms.h"
+#include "GLStateCache.h"
+
+#include <cassert>
+#include <cstring>
 
 Shader::Shader(uint32_t _vertexShaderId, uint32_t _fragmentShaderId, uint32_t _programId) {
     vertex_shader_id = _vertexShaderId;
@@ -7,51 +12,146 @@ Shader::Shader(uint32_t _vertexShaderId, uint32_t _fragmentShaderId, uint32_t _p
 }
 
 void Shader::Use() const {
-    glUseProgram(program_id);
+    GLStateCache::UseProgram(program_id);
+}
+
+void Shader::CacheUniformLocations() {
+    GLint uniform_count = 0;
+    GLint name_max_length = 0;
+
+    uniform_slots.fill({});
+
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &uniform_count);
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &name_max_length);
+
+    std::string name(name_max_length, '\0');
+
+    for (int i = 0; i < uniform_count; ++i) {
+        GLsizei name_length = 0;
+        GLint array_size = 0;
+        GLenum type;
+
+        glGetActiveUniform(program_id, i, name_max_length, &name_length, &array_size, &type, name.data());
+
+        std::string uniform_name = name.substr(0, name_length);
+        GLint location = glGetUniformLocation(program_id, uniform_name.c_str());
+
+        // uniforms that live in a block don't have a location
+        if (location == -1)
+            continue;
+
+        AddUniformLocation(uniform_name.c_str(), location);
+
+        // arrays are reported as "name[0]", so we also register the bare name and every element
+        if (uniform_name.ends_with("[0]")) {
+            std::string array_name = uniform_name.substr(0, uniform_name.size() - 3);
+
+            AddUniformLocation(array_name.c_str(), location);
+
+            for (int j = 1; j < array_size; ++j) {
+                std::string element_name = array_name + "[" + std::to_string(j) + "]";
+
+                AddUniformLocation(element_name.c_str(), glGetUniformLocation(program_id, element_name.c_str()));
+            }
+        }
+    }
 }
 
-void Shader::SetBool(const char *_name, bool _value) const {
-    glProgramUniform1ui(program_id, glGetUniformLocation(program_id, _name), (int) _value);
+void Shader::AddUniformLocation(const char *_name, GLint _location) {
+    const uint32_t hash = UniformName::Hash(_name);
+
+    for (int i = 0; i < UNIFORM_SLOT_COUNT; ++i) {
+        UniformSlot &slot = uniform_slots[(hash + i) & (UNIFORM_SLOT_COUNT - 1)];
+
+        // both names would resolve to the same slot, so neither of them is given a location (writes to -1 are ignored, instead of landing on the other uniform)
+        if (slot.hash == hash) {
+            std::cout << "ERROR::SHADER::UNIFORM_HASH_COLLISION -> (" << _name << ") & (" << GetSlotName(slot) << ")" << std::endl;
+            slot.location = -1;
+            assert(false && "uniform names collide in the location table, rename one of them");
+            return;
+        }
+
+        if (slot.hash == 0) {
+            slot.hash = hash;
+            slot.location = _location;
+#ifndef NDEBUG
+            slot.name = _name;
+#endif
+            return;
+        }
+    }
+
+    std::cout << "ERROR::SHADER::TOO_MANY_UNIFORMS -> (" << _name << ")" << std::endl;
 }
 
-void Shader::SetInt(const char *_name, int _value) const {
-    glProgramUniform1i(program_id, glGetUniformLocation(program_id, _name), _value);
+const char *Shader::GetSlotName(const UniformSlot &_slot) {
+#ifndef NDEBUG
+    return _slot.name.c_str();
+#else
+    return "?";
+#endif
 }
 
-void Shader::SetFloat(const char *_name, float _value) const {
-    glProgramUniform1f(program_id, glGetUniformLocation(program_id, _name), _value);
+GLint Shader::GetUniformLocation(UniformName _name) const {
+    // linear probing, which almost always resolves on the first slot
+    for (int i = 0; i < UNIFORM_SLOT_COUNT; ++i) {
+        const UniformSlot &slot = uniform_slots[(_name.hash + i) & (UNIFORM_SLOT_COUNT - 1)];
+
+        if (slot.hash == _name.hash) {
+            // an inactive uniform whose name collides with an active one's
+            assert(std::strcmp(GetSlotName(slot), _name.name) == 0 && "uniform name collides with another uniform's in the location table");
+            return slot.location;
+        }
+
+        if (slot.hash == 0)
+            break;
+    }
+
+    return -1;
 }
 
-void Shader::SetFloatFast(const char *_name, float _value) const {
-    glUniform1f(glGetUniformLocation(program_id, _name), _value);
+void Shader::SetBool(UniformName _name, bool _value) const {
+    glProgramUniform1ui(program_id, GetUniformLocation(_name), (int) _value);
 }
 
-void Shader::SetVec2(const char *_name, float _valueX, float _valueY) const {
-    glProgramUniform2f(program_id, glGetUniformLocation(program_id, _name), _valueX, _valueY);
+void Shader::SetInt(UniformName _name, int _value) const {
+    glProgramUniform1i(program_id, GetUniformLocation(_name), _value);
 }
 
-void Shader::SetVec3(const char *_name, float _valueX, float _valueY, float _valueZ) const {
-    glProgramUniform3f(program_id, glGetUniformLocation(program_id, _name), _valueX, _valueY, _valueZ);
+void Shader::SetFloat(UniformName _name, float _value) const {
+    glProgramUniform1f(program_id, GetUniformLocation(_name), _value);
 }
 
-void Shader::SetVec3(const char *_name, const glm::vec3& _value) const {
-    glProgramUniform3f(program_id, glGetUniformLocation(program_id, _name), _value.x, _value.y, _value.z);
+void Shader::SetFloatFast(UniformName _name, float _value) const {
+    glUniform1f(GetUniformLocation(_name), _value);
 }
 
-void Shader::SetTexture(const char *_name, GLint _value) const {
+void Shader::SetVec2(UniformName _name, float _valueX, float _valueY) const {
+    glProgramUniform2f(program_id, GetUniformLocation(_name), _valueX, _valueY);
+}
+
+void Shader::SetVec3(UniformName _name, float _valueX, float _valueY, float _valueZ) const {
+    glProgramUniform3f(program_id, GetUniformLocation(_name), _valueX, _valueY, _valueZ);
+}
+
+void Shader::SetVec3(UniformName _name, const glm::vec3& _value) const {
+    glProgramUniform3f(program_id, GetUniformLocation(_name), _value.x, _value.y, _value.z);
+}
+
+void Shader::SetTexture(UniformName _name, GLint _value) const {
     SetInt(_name, _value);
 }
 
-void Shader::SetMat4(const char *_name, const glm::mat4 &_value) const {
-    glProgramUniformMatrix4fv(program_id, glGetUniformLocation(program_id, _name), 1, GL_FALSE, glm::value_ptr(_value));
+void Shader::SetMat4(UniformName _name, const glm::mat4 &_value) const {
+    glProgramUniformMatrix4fv(program_id, GetUniformLocation(_name), 1, GL_FALSE, glm::value_ptr(_value));
 }
 
 void Shader::SetModelMatrix(const glm::mat4 &_transform) const {
-    glProgramUniformMatrix4fv(program_id, glGetUniformLocation(program_id, "u_model_transform"), 1, GL_FALSE, glm::value_ptr(_transform));
+    glProgramUniformMatrix4fv(program_id, GetUniformLocation("u_model_transform"), 1, GL_FALSE, glm::value_ptr(_transform));
 }
 
 void Shader::SetViewProjectionMatrix(const glm::mat4 &_transform) const {
-    glProgramUniformMatrix4fv(program_id, glGetUniformLocation(program_id, "u_view_projection"), 1, GL_FALSE, glm::value_ptr(_transform));
+    glProgramUniformMatrix4fv(program_id, GetUniformLocation("u_view_projection"), 1, GL_FALSE, glm::value_ptr(_transform));
 }
 
 Shader::Library::Library() {
@@ -59,39 +159,43 @@ Shader::Library::Library() {
     Shader::Library::compiled_shader_library = std::unordered_map<std::string, std::shared_ptr<Shader>>();
 }
 
-std::shared_ptr<Shader> Shader::Library::CreateShader(const std::string& _vertexShaderPath, const std::string& _fragmentShaderPath) {
-    std::string shaderCode;
-    uint32_t vertex_id;
-    uint32_t fragment_id;
-    std::shared_ptr<Shader> compiled_shader;
-
-    if (Shader::Library::shader_library.contains(_vertexShaderPath)) {
-        vertex_id = Shader::Library::shader_library[_vertexShaderPath];
-    } else {
-        shaderCode = Shader::Library::ReadShaderCode(_vertexShaderPath);
-
-        vertex_id = Shader::Library::AddShader(_vertexShaderPath, GL_VERTEX_SHADER, 1, shaderCode.c_str());
-    }
+std::shared_ptr<Shader> Shader::Library::CreateShader(const std::string& _vertexShaderPath, const std::string& _fragmentShaderPath, const std::string& _defines) {
+    return CreateShader(_vertexShaderPath, "", _fragmentShaderPath, _defines);
+}
 
-    if (Shader::Library::shader_library.contains(_fragmentShaderPath)) {
-        fragment_id = Shader::Library::shader_library[_fragmentShaderPath];
-    } else {
-        shaderCode = Shader::Library::ReadShaderCode(_fragmentShaderPath);
+std::shared_ptr<Shader> Shader::Library::CreateShader(const std::string& _vertexShaderPath, const std::string& _geometryShaderPath, const std::string& _fragmentShaderPath, const std::string& _defines) {
+    std::shared_ptr<Shader> compiled_shader;
 
-        fragment_id = Shader::Library::AddShader(_fragmentShaderPath, GL_FRAGMENT_SHADER, 1, shaderCode.c_str());
-    }
+    uint32_t vertex_id = Shader::Library::GetOrAddShader(_vertexShaderPath, GL_VERTEX_SHADER, _defines);
+    uint32_t geometry_id = _geometryShaderPath.empty() ? 0 : Shader::Library::GetOrAddShader(_geometryShaderPath, GL_GEOMETRY_SHADER, _defines);
+    uint32_t fragment_id = Shader::Library::GetOrAddShader(_fragmentShaderPath, GL_FRAGMENT_SHADER, _defines);
 
     auto shader_name = std::to_string(vertex_id).append("-").append(std::to_string(fragment_id));
 
+    if (geometry_id != 0)
+        shader_name.append("-").append(std::to_string(geometry_id));
+
     if (Shader::Library::compiled_shader_library.contains(shader_name)) {
         compiled_shader = Shader::Library::compiled_shader_library[shader_name];
     } else {
-        compiled_shader = Shader::Library::AddProgram(shader_name, vertex_id, fragment_id);
+        compiled_shader = Shader::Library::AddProgram(shader_name, vertex_id, fragment_id, geometry_id);
     }
 
     return compiled_shader;
 }
 
+uint32_t Shader::Library::GetOrAddShader(const std::string& _shaderCodePath, GLenum _type, const std::string& _defines) {
+    // variants of a same file are different shaders
+    const auto name = _defines.empty() ? _shaderCodePath : _shaderCodePath + "|" + _defines;
+
+    if (Shader::Library::shader_library.contains(name))
+        return Shader::Library::shader_library[name];
+
+    const std::string shaderCode = Shader::Library::InsertDefines(Shader::Library::ReadShaderCode(_shaderCodePath), _defines);
+
+    return Shader::Library::AddShader(name, _type, 1, shaderCode.c_str());
+}
+
 std::shared_ptr<Shader> Shader::Library::CreateShader(uint32_t _vertexShaderId, uint32_t _fragmentShaderId) {
     auto vertexShaderIdCString = std::to_string(_vertexShaderId);
     auto fragmentShaderIdCString = std::to_string(_fragmentShaderId);
@@ -119,7 +223,7 @@ Shader::Library::AddShader(const std::string& _name, GLenum _type, GLsizei _coun
     if (!success) {
         glGetShaderInfoLog(shader_id, 512, nullptr, log);
 
-        std::cout << "ERROR::SHADER::" << ((_type == GL_VERTEX_SHADER) ? "VERTEX" : "FRAGMENT")
+        std::cout << "ERROR::SHADER::" << ((_type == GL_VERTEX_SHADER) ? "VERTEX" : (_type == GL_GEOMETRY_SHADER) ? "GEOMETRY" : "FRAGMENT")
                   << "::COMPILATION_FAILED -> (" << _name << ") " << log << std::endl;
     }
 
@@ -128,7 +232,7 @@ Shader::Library::AddShader(const std::string& _name, GLenum _type, GLsizei _coun
     return shader_id;
 }
 
-std::shared_ptr<Shader> Shader::Library::AddProgram(const std::string& _name, uint32_t _vertexId, uint32_t _fragmentId) {
+std::shared_ptr<Shader> Shader::Library::AddProgram(const std::string& _name, uint32_t _vertexId, uint32_t _fragmentId, uint32_t _geometryId) {
     int program_id;
     int success;
     char log[512];
@@ -136,6 +240,9 @@ std::shared_ptr<Shader> Shader::Library::AddProgram(const std::string& _name, ui
     program_id = glCreateProgram();
     glAttachShader(program_id, _vertexId);
     glAttachShader(program_id, _fragmentId);
+
+    if (_geometryId != 0)
+        glAttachShader(program_id, _geometryId);
     glLinkProgram(program_id);
 
     //error printing, if any
@@ -148,6 +255,16 @@ std::shared_ptr<Shader> Shader::Library::AddProgram(const std::string& _name, ui
     }
 
     std::shared_ptr<Shader> compiled_shader = std::make_shared<Shader>(_vertexId, _fragmentId, program_id);
+    compiled_shader->geometry_shader_id = _geometryId;
+
+    // resolves every uniform location once, now that the program is linked
+    compiled_shader->CacheUniformLocations();
+
+    // points the program's per-pass block (if it declares one) at the shared buffer
+    GLuint frame_block_index = glGetUniformBlockIndex(program_id, FrameUniforms::BLOCK_NAME);
+
+    if (frame_block_index != GL_INVALID_INDEX)
+        glUniformBlockBinding(program_id, frame_block_index, FrameUniforms::BINDING);
 
     Shader::Library::compiled_shader_library[_name] = compiled_shader;
 
@@ -172,7 +289,7 @@ std::string Shader::Library::ReadShaderCode(const std::string& _shaderCodePath)
         //closes file handlers
         shaderFile.close();
 
-        shaderCodeString = shaderStream.str();
+        shaderCodeString = ResolveIncludes(shaderStream.str(), _shaderCodePath);
     } catch (std::ifstream::failure &e) {
         std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ -> " << e.what() << std::endl << "Path: "
                   << _shaderCodePath << std::endl;
@@ -181,3 +298,39 @@ std::string Shader::Library::ReadShaderCode(const std::string& _shaderCodePath)
 
     return shaderCodeString;
 }
+
+std::string Shader::Library::InsertDefines(const std::string& _shaderCode, const std::string& _defines) {
+    if (_defines.empty())
+        return _shaderCode;
+
+    //#version has to stay the first directive, so the defines go on the line right after it
+    const auto version_position = _shaderCode.find("#version");
+    const auto insert_position = version_position == std::string::npos ? 0 : _shaderCode.find('\n', version_position) + 1;
+
+    std::string shaderCode = _shaderCode;
+    shaderCode.insert(insert_position, _defines.ends_with('\n') ? _defines : _defines + '\n');
+
+    return shaderCode;
+}
+
+std::string Shader::Library::ResolveIncludes(const std::string& _shaderCode, const std::string& _shaderCodePath) {
+    const std::string include_directive = "#include \"";
+    const std::string directory = _shaderCodePath.substr(0, _shaderCodePath.find_last_of('/') + 1);
+
+    std::stringstream resolvedStream;
+    std::istringstream codeStream(_shaderCode);
+    std::string line;
+
+    //replaces every include line with the contents of the file it points to, relative to the including file
+    while (std::getline(codeStream, line)) {
+        if (line.starts_with(include_directive)) {
+            std::string include_path = directory + line.substr(include_directive.size(), line.find_last_of('"') - include_directive.size());
+
+            resolvedStream << ReadShaderCode(include_path) << '\n';
+        } else {
+            resolvedStream << line << '\n';
+        }
+    }
+
+    return resolvedStream.str();
+}
@@ -6,12 +6,12 @@
 #include "glm/vec2.hpp"
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/type_ptr.hpp"
-#include "Light.h"
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <memory>
+#include <array>
 #include <unordered_map>
 
 class Shader {
@@ -24,14 +24,41 @@ public:
     public:
         Library();
 
-        static std::shared_ptr<Shader> CreateShader(const std::string& _vertexShaderPath, const std::string& _fragmentShaderPath);
+        // _defines (e.g. "#define NAME 1\n") is inserted right after the #version line of both stages, so that one file can give several variants
+        static std::shared_ptr<Shader> CreateShader(const std::string& _vertexShaderPath, const std::string& _fragmentShaderPath, const std::string& _defines = "");
+        static std::shared_ptr<Shader> CreateShader(const std::string& _vertexShaderPath, const std::string& _geometryShaderPath, const std::string& _fragmentShaderPath, const std::string& _defines);
         static std::shared_ptr<Shader> CreateShader(uint32_t _vertexShaderId, uint32_t _fragmentShaderPath);
 
         static uint32_t AddShader(const std::string& _name, GLenum _type, GLsizei _count, const char* _code, const GLint* _length = nullptr);
-        static std::shared_ptr<Shader> AddProgram(const std::string& _name, uint32_t _vertexId, uint32_t _fragmentId);
+        static std::shared_ptr<Shader> AddProgram(const std::string& _name, uint32_t _vertexId, uint32_t _fragmentId, uint32_t _geometryId = 0);
 
     private:
+        static uint32_t GetOrAddShader(const std::string& _shaderCodePath, GLenum _type, const std::string& _defines); // compiles a stage once per file & defines
         static std::string ReadShaderCode(const std::string& shaderCodePath);
+        static std::string InsertDefines(const std::string& _shaderCode, const std::string& _defines);
+        static std::string ResolveIncludes(const std::string& _shaderCode, const std::string& _shaderCodePath); // GLSL has no includes, so we expand them ourselves
+    };
+
+    // Name of a uniform, hashed at compile-time so that lookups never have to go through the driver
+    // The consteval constructor means any string literal passed to a setter is hashed by the compiler
+    struct UniformName {
+    public:
+        uint32_t hash;
+        const char *name;
+
+        consteval UniformName(const char *_name) : hash(Hash(_name)), name(_name) {}
+
+        // FNV-1a hash, 0 is reserved to mark empty slots in the location table
+        static constexpr uint32_t Hash(const char *_name) {
+            uint32_t hash = 2166136261u;
+
+            for (; *_name != '\0'; ++_name) {
+                hash ^= (uint8_t) *_name;
+                hash *= 16777619u;
+            }
+
+            return hash == 0 ? 1 : hash;
+        }
     };
 
     // Describes all of a shader's properties (regardless of whether they are used or not)
@@ -45,40 +72,68 @@ public:
         glm::vec3 color = glm::vec3(1.0f);
         float alpha = 1.0f;
 
-        std::shared_ptr<Light> main_light = std::make_shared<Light>();
-
         GLuint texture = 0;
         float texture_influence = 0.0f;
 
         int shininess = 32;
+
+        bool casts_shadows = true; // whether it is drawn into the shadow maps
+        bool receives_shadows = true; // whether the lit shaders look it up in the shadow maps
     };
 
 public:
     uint32_t program_id;
     uint32_t vertex_shader_id;
     uint32_t fragment_shader_id;
+    uint32_t geometry_shader_id = 0; // if it has one
+
+    // same program, but reading its model matrix (and color) from per-instance attributes, if it has one
+    std::shared_ptr<Shader> instanced_variant = nullptr;
+
+private:
+    // open-addressed table of the program's active uniform locations, keyed by their name's hash
+    // must be a power of 2, so that the hash can be masked into an index
+    inline constexpr static int UNIFORM_SLOT_COUNT = 64;
+
+    struct UniformSlot {
+        uint32_t hash = 0;
+        GLint location = -1;
+
+#ifndef NDEBUG
+        std::string name; // checked against every lookup, so that a collision can never resolve to another uniform unnoticed
+#endif
+    };
+
+    std::array<UniformSlot, UNIFORM_SLOT_COUNT> uniform_slots{};
 
 public:
     Shader(uint32_t _vertexShaderId, uint32_t _fragmentShaderId, uint32_t _programId);
 
     void Use() const; //activates the shader
 
-    void SetBool(const char* _name, bool _value) const; // utility function to set a bool value
-    void SetInt(const char *_name, int _value) const;  // utility function to set a int _value
+    void CacheUniformLocations(); // queries every active uniform of the linked program once, so that setters don't have to
+    [[nodiscard]] GLint GetUniformLocation(UniformName _name) const; // cached location of a uniform, -1 if it isn't active
 
-    void SetFloat(const char *_name, float _value) const; // utility function to set a float _value
-    void SetFloatFast(const char *_name, float _value) const; // utility function to set a flow value on an active program
+    void SetBool(UniformName _name, bool _value) const; // utility function to set a bool value
+    void SetInt(UniformName _name, int _value) const;  // utility function to set a int _value
 
-    void SetVec2(const char *_name, float _valueX, float _valueY) const; // utility function to set a vector 2
+    void SetFloat(UniformName _name, float _value) const; // utility function to set a float _value
+    void SetFloatFast(UniformName _name, float _value) const; // utility function to set a flow value on an active program
+
+    void SetVec2(UniformName _name, float _valueX, float _valueY) const; // utility function to set a vector 2
 
     // utility functions to set a vector 3
-    void SetVec3(const char *_name, float _valueX, float _valueY, float _valueZ) const;
-    void SetVec3(const char *_name, const glm::vec3& _value) const;
+    void SetVec3(UniformName _name, float _valueX, float _valueY, float _valueZ) const;
+    void SetVec3(UniformName _name, const glm::vec3& _value) const;
 
-    void SetMat4(const char *_name, const glm::mat4 &_value) const; // utility function to set a matrix 4x4
+    void SetMat4(UniformName _name, const glm::mat4 &_value) const; // utility function to set a matrix 4x4
 
-    void SetTexture(const char *_name, GLint _value) const; // utility function to set a texture
+    void SetTexture(UniformName _name, GLint _value) const; // utility function to set a texture
     void SetModelMatrix(const glm::mat4& _transform) const; // utility function to set model matrix
     void SetViewProjectionMatrix(const glm::mat4& _transform) const; // utility function to set projection matrix
+
+private:
+    void AddUniformLocation(const char *_name, GLint _location); // inserts a location into the lookup table
+    [[nodiscard]] static const char *GetSlotName(const UniformSlot &_slot); // "?" in release builds, which don't keep the names
 };
 
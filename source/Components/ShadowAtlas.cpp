@@ -0,0 +1,413 @@
+#include "ShadowAtlas.h"
+
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <numeric>
+#include <iostream>
+#include "glm/ext/matrix_transform.hpp"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "GLStateCache.h"
+#include "Utility/Bounds.hpp"
+#include "Utility/Frustum.hpp"
+
+ShadowAtlas::ShadowAtlas() {
+    // compared by the hardware when sampled, like the main light's shadow maps
+    glGenTextures(1, &atlas_tex);
+    GLStateCache::BindTexture(ATLAS_UNIT, GL_TEXTURE_2D, atlas_tex);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, ATLAS_SIZE, ATLAS_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, &atlas_fbo);
+    GLStateCache::BindFramebuffer(atlas_fbo);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, atlas_tex, 0);
+
+    // depth only
+    glReadBuffer(GL_NONE);
+    glDrawBuffer(GL_NONE);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR -> Framebuffer is not complete!" << std::endl;
+
+    // tiles clear their own part of it before being rendered, this only makes the unused parts sensible
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    GLStateCache::BindFramebuffer(0);
+    GLStateCache::BindTexture(ATLAS_UNIT, GL_TEXTURE_2D, 0);
+
+    glGenBuffers(1, &tiles_buffer_o);
+    glBindBuffer(GL_TEXTURE_BUFFER, tiles_buffer_o);
+    glBufferData(GL_TEXTURE_BUFFER, MAX_TILES * TILE_TEXELS * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &tiles_tex);
+    GLStateCache::BindTexture(TILES_UNIT, GL_TEXTURE_BUFFER, tiles_tex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, tiles_buffer_o);
+    GLStateCache::BindTexture(TILES_UNIT, GL_TEXTURE_BUFFER, 0);
+}
+
+ShadowAtlas::~ShadowAtlas() {
+    const std::array<GLuint, 2> textures = {atlas_tex, tiles_tex};
+
+    glDeleteFramebuffers(1, &atlas_fbo);
+    glDeleteTextures((GLsizei)textures.size(), textures.data());
+    glDeleteBuffers(1, &tiles_buffer_o);
+}
+
+void ShadowAtlas::Update(std::span<ClusteredLights::PointLight> _lights, const Camera &_camera, bool _enabled) {
+    ++frame;
+
+    for (auto &light : _lights)
+        light.shadow_tile = -1;
+
+    // importance of every light the camera sees, i.e. how large it looks: its radius over its distance
+    candidates.clear();
+
+    if (_enabled) {
+        const Frustum camera_frustum(_camera.GetViewProjection());
+        const glm::vec3 camera_position = _camera.GetPosition();
+
+        for (size_t i = 0; i < _lights.size(); ++i) {
+            const auto &light = _lights[i];
+
+            Bounds light_bounds;
+            light_bounds.Add(light.position - glm::vec3(light.radius));
+            light_bounds.Add(light.position + glm::vec3(light.radius));
+
+            if (!camera_frustum.Intersects(light_bounds))
+                continue;
+
+            const float distance = glm::length(light.position - camera_position);
+            candidates.emplace_back(light.radius / std::max(distance, light.radius), i);
+        }
+    }
+
+    // only the most important lights get shadows, those that have them already ranking higher, so that lights near the cut don't take turns (rendering new tiles every time)
+    has_tiles.assign(_lights.size(), 0);
+
+    for (const auto &tile : tiles) {
+        if (tile.light < has_tiles.size())
+            has_tiles[tile.light] = 1;
+    }
+
+    const auto rank_of = [&](const std::pair<float, size_t> &_candidate) { return _candidate.first * (has_tiles[_candidate.second] ? SHADOWED_LIGHT_RANK_BIAS : 1.0f); };
+
+    const size_t shadowed_count = std::min(candidates.size(), (size_t)MAX_SHADOWED_LIGHTS);
+    std::partial_sort(candidates.begin(), candidates.begin() + (ptrdiff_t)shadowed_count, candidates.end(), [&](const auto &_a, const auto &_b) { return rank_of(_a) > rank_of(_b); });
+
+    stats = {.dropped_lights = (int)(candidates.size() - shadowed_count), .allocated_sets = stats.allocated_sets, .failed_allocations = stats.failed_allocations};
+    candidates.resize(shadowed_count);
+
+    // power of two tile sizes, so that the tiles pack without gaps
+    tile_sizes.resize(candidates.size());
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const float scaled_importance = candidates[i].first * TILE_SIZE_SCALE;
+        tile_sizes[i] = (int)std::bit_floor((unsigned)std::clamp(scaled_importance, (float)MIN_TILE_SIZE, (float)MAX_TILE_SIZE));
+
+        // a light near the edge of its size's range would otherwise get new tiles back & forth as the camera moves
+        const int current_set = FindNewestSet(candidates[i].second, false);
+
+        if (current_set < 0)
+            continue;
+
+        const auto current_size = (float)tiles[current_set].size;
+
+        if (scaled_importance >= current_size * (1.0f - TILE_SIZE_HYSTERESIS) && scaled_importance < 2.0f * current_size * (1.0f + TILE_SIZE_HYSTERESIS))
+            tile_sizes[i] = tiles[current_set].size;
+    }
+
+    // the least important lights' tiles are shrunk first, then dropped, until every face fits in the atlas
+    const auto units_of = [](int _tileSize) { return FACE_COUNT * (_tileSize / MIN_TILE_SIZE) * (_tileSize / MIN_TILE_SIZE); };
+
+    int used_unit_count = std::transform_reduce(tile_sizes.begin(), tile_sizes.end(), 0, std::plus<>(), units_of);
+
+    while (used_unit_count > UNIT_COUNT) {
+        const auto shrinkable = std::find_if(tile_sizes.rbegin(), tile_sizes.rend(), [](int _tileSize) { return _tileSize > MIN_TILE_SIZE; });
+
+        if (shrinkable != tile_sizes.rend()) {
+            used_unit_count -= units_of(*shrinkable) - units_of(*shrinkable / 2);
+            *shrinkable /= 2;
+        } else {
+            used_unit_count -= units_of(tile_sizes.back());
+            tile_sizes.pop_back();
+            candidates.pop_back();
+            ++stats.dropped_lights;
+        }
+    }
+
+    Allocate(_lights);
+
+    for (auto &tile : tiles) {
+        const auto candidate = std::find_if(candidates.begin(), candidates.end(), [&](const auto &_candidate) { return _candidate.second == tile.light; });
+        tile.importance = candidate != candidates.end() ? candidate->first : 0.0f;
+    }
+
+    Schedule();
+
+    // a light is shadowed by its newest set that has every face rendered, an older one being kept (& used) until then
+    for (const auto &[importance, light] : candidates) {
+        const int ready_set = FindNewestSet(light, true);
+
+        if (ready_set < 0)
+            continue;
+
+        _lights[light].shadow_tile = ready_set;
+        ++stats.shadowed_lights;
+    }
+
+    stats.tiles = (int)tiles.size();
+
+    Upload();
+}
+
+void ShadowAtlas::Bind() const {
+    GLStateCache::BindTexture(ATLAS_UNIT, GL_TEXTURE_2D, atlas_tex);
+    GLStateCache::BindTexture(TILES_UNIT, GL_TEXTURE_BUFFER, tiles_tex);
+}
+
+void ShadowAtlas::InvalidateBounds(const Bounds &_worldBounds) {
+    if (_worldBounds.IsEmpty())
+        return;
+
+    for (auto &tile : tiles) {
+        // never rendered tiles are scheduled anyway, & the dirty ones needn't be tested again
+        if (tile.last_update < 0 || tile.dirty)
+            continue;
+
+        tile.dirty = Frustum(tile.view_projection).Intersects(_worldBounds);
+    }
+}
+
+void ShadowAtlas::Allocate(std::span<const ClusteredLights::PointLight> _lights) {
+    const auto target_size_of = [&](size_t _light) {
+        const auto candidate = std::find_if(candidates.begin(), candidates.end(), [&](const auto &_candidate) { return _candidate.second == _light; });
+        return candidate != candidates.end() ? tile_sizes[candidate - candidates.begin()] : 0;
+    };
+
+    // backwards, so that a light's newer sets are settled before its older ones
+    for (size_t first_tile = tiles.size(); first_tile > 0;) {
+        first_tile -= FACE_COUNT;
+
+        const Tile &tile = tiles[first_tile];
+        const int target_size = target_size_of(tile.light);
+
+        // a light that isn't shadowed anymore (or that moved, its tiles being stale) frees its sets right away
+        bool kept = target_size > 0 && tile.light < _lights.size() && tile.view_projection == GetFaceViewProjection(_lights[tile.light], tile.face);
+
+        // a set is only kept until a newer one is ready
+        if (FindNewestSet(tile.light, true) > (int)first_tile)
+            kept = false;
+
+        if (!kept)
+            FreeSet(first_tile);
+    }
+
+    // the most important lights first, so that they're the ones that get the room left
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const size_t light = candidates[i].second;
+        const int newest_set = FindNewestSet(light, false);
+        const int ready_set = FindNewestSet(light, true);
+
+        if (newest_set >= 0 && tiles[newest_set].size == tile_sizes[i])
+            continue;
+
+        // back to the size it is shadowed with, before its replacement was ready
+        if (ready_set >= 0 && ready_set != newest_set && tiles[ready_set].size == tile_sizes[i]) {
+            FreeSet(newest_set);
+            continue;
+        }
+
+        // without room for its size, a smaller one is better than nothing, but not than what the light already has
+        bool allocated = false;
+
+        for (int tile_size = tile_sizes[i]; tile_size >= MIN_TILE_SIZE && !allocated; tile_size /= 2) {
+            if (newest_set >= 0 && tiles[newest_set].size == tile_size)
+                break;
+
+            allocated = AllocateSet(_lights[light], light, tile_size);
+        }
+
+        if (!allocated) {
+            ++stats.failed_allocations;
+            continue;
+        }
+
+        ++stats.allocated_sets;
+
+        // a replacement that was never ready is superseded right away, the light's shown set (if any) being kept
+        if (newest_set >= 0 && newest_set != ready_set)
+            FreeSet(newest_set);
+    }
+
+    for (size_t first_tile = 0; first_tile < tiles.size(); first_tile += FACE_COUNT)
+        stats.replaced_sets += FindNewestSet(tiles[first_tile].light, false) > (int)first_tile;
+}
+
+bool ShadowAtlas::AllocateSet(const ClusteredLights::PointLight &_light, size_t _lightIndex, int _tileSize) {
+    // a power of two tile covers an aligned block of minimum sized tiles along the Z-order curve, so the first free block of its size is a free square
+    const auto tile_units = (uint32_t)((_tileSize / MIN_TILE_SIZE) * (_tileSize / MIN_TILE_SIZE));
+    const size_t first_tile = tiles.size();
+
+    const auto is_free = [&](uint32_t _firstUnit) {
+        for (uint32_t unit = _firstUnit; unit < _firstUnit + tile_units; ++unit) {
+            if (used_units.test(unit))
+                return false;
+        }
+
+        return true;
+    };
+
+    // the largest tiles are placed from the start of the curve & the others from its end, so that small tiles don't break up the room large ones need
+    const bool from_end = _tileSize < MAX_TILE_SIZE;
+
+    for (int face = 0; face < FACE_COUNT; ++face) {
+        auto first_unit = from_end ? (int64_t)(UNIT_COUNT - tile_units) : 0;
+
+        while (first_unit >= 0 && first_unit < UNIT_COUNT && !is_free((uint32_t)first_unit))
+            first_unit += from_end ? -(int64_t)tile_units : (int64_t)tile_units;
+
+        // the faces placed so far are given back
+        if (first_unit < 0 || first_unit >= UNIT_COUNT) {
+            for (size_t i = first_tile; i < tiles.size(); ++i) {
+                for (uint32_t unit = tiles[i].first_unit; unit < tiles[i].first_unit + tile_units; ++unit)
+                    used_units.reset(unit);
+            }
+
+            tiles.resize(first_tile);
+
+            return false;
+        }
+
+        for (auto unit = (uint32_t)first_unit; unit < first_unit + tile_units; ++unit)
+            used_units.set(unit);
+
+        tiles.push_back({
+            .light = _lightIndex,
+            .face = face,
+            .offset = GetZOrderPosition((uint32_t)first_unit) * MIN_TILE_SIZE,
+            .size = _tileSize,
+            .first_unit = (uint32_t)first_unit,
+            .view_projection = GetFaceViewProjection(_light, face),
+        });
+    }
+
+    return true;
+}
+
+void ShadowAtlas::FreeSet(size_t _firstTile) {
+    const auto first = tiles.begin() + (ptrdiff_t)_firstTile;
+
+    for (auto tile = first; tile != first + FACE_COUNT; ++tile) {
+        const auto tile_units = (uint32_t)((tile->size / MIN_TILE_SIZE) * (tile->size / MIN_TILE_SIZE));
+
+        for (uint32_t unit = tile->first_unit; unit < tile->first_unit + tile_units; ++unit)
+            used_units.reset(unit);
+    }
+
+    tiles.erase(first, first + FACE_COUNT);
+}
+
+int ShadowAtlas::FindNewestSet(size_t _light, bool _ready) const {
+    for (size_t first_tile = tiles.size(); first_tile > 0;) {
+        first_tile -= FACE_COUNT;
+
+        if (tiles[first_tile].light == _light && (!_ready || IsReady(first_tile)))
+            return (int)first_tile;
+    }
+
+    return -1;
+}
+
+bool ShadowAtlas::IsReady(size_t _firstTile) const {
+    const auto first = tiles.begin() + (ptrdiff_t)_firstTile;
+
+    return std::none_of(first, first + FACE_COUNT, [](const Tile &_tile) { return _tile.last_update < 0; });
+}
+
+void ShadowAtlas::Schedule() {
+    // dirty tiles first (they show a caster where it isn't anymore), then never rendered ones (their last update being -1), then the least recently rendered, the most important first among equals
+    tile_order.resize(tiles.size());
+    std::iota(tile_order.begin(), tile_order.end(), 0);
+
+    std::sort(tile_order.begin(), tile_order.end(), [&](int _a, int _b) {
+        if (tiles[_a].dirty != tiles[_b].dirty)
+            return tiles[_a].dirty;
+
+        if (tiles[_a].last_update != tiles[_b].last_update)
+            return tiles[_a].last_update < tiles[_b].last_update;
+
+        return tiles[_a].importance > tiles[_b].importance;
+    });
+
+    const auto scheduled_count = std::min(tile_order.size(), (size_t)std::max(update_budget, 0));
+    scheduled_tiles.assign(tile_order.begin(), tile_order.begin() + (ptrdiff_t)scheduled_count);
+
+    // the renderer draws every scheduled tile this frame
+    for (int tile_index : scheduled_tiles) {
+        tiles[tile_index].last_update = frame;
+        tiles[tile_index].dirty = false;
+    }
+
+    stats.updated_tiles = (int)scheduled_tiles.size();
+    stats.pending_tiles = (int)std::count_if(tiles.begin(), tiles.end(), [](const Tile &_tile) { return _tile.last_update < 0; });
+    stats.stale_tiles = (int)std::count_if(tiles.begin(), tiles.end(), [](const Tile &_tile) { return _tile.dirty; });
+}
+
+void ShadowAtlas::Upload() {
+    tile_texels.resize(tiles.size() * TILE_TEXELS);
+
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const Tile &tile = tiles[i];
+
+        for (int column = 0; column < 4; ++column)
+            tile_texels[i * TILE_TEXELS + column] = tile.view_projection[column];
+
+        tile_texels[i * TILE_TEXELS + 4] = glm::vec4(glm::vec2(tile.offset) / (float)ATLAS_SIZE, (float)tile.size / ATLAS_SIZE, DEPTH_BIAS);
+    }
+
+    // the previous storage is orphaned, so that the GPU can keep reading it
+    glBindBuffer(GL_TEXTURE_BUFFER, tiles_buffer_o);
+    glBufferData(GL_TEXTURE_BUFFER, MAX_TILES * TILE_TEXELS * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+
+    if (!tile_texels.empty())
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)(tile_texels.size() * sizeof(glm::vec4)), tile_texels.data());
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+glm::ivec2 ShadowAtlas::GetZOrderPosition(uint32_t _index) {
+    glm::ivec2 position = glm::ivec2(0);
+
+    // x is in the even bits, y in the odd ones
+    for (int bit = 0; bit < 16; ++bit) {
+        position.x |= (int)((_index >> (2 * bit)) & 1u) << bit;
+        position.y |= (int)((_index >> (2 * bit + 1)) & 1u) << bit;
+    }
+
+    return position;
+}
+
+glm::mat4 ShadowAtlas::GetFaceViewProjection(const ClusteredLights::PointLight &_light, int _face) {
+    // same faces as the main light's cube, but exactly 90 degrees wide, since the lit shaders pick a face by the major axis
+    static const std::array<std::array<glm::vec3, 2>, FACE_COUNT> face_directions = {{
+        {glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)},
+        {glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)},
+        {glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)},
+        {glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f)},
+        {glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f)},
+        {glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f)},
+    }};
+
+    const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, NEAR_PLANE, std::max(_light.radius, 2.0f * NEAR_PLANE));
+
+    return projection * glm::lookAt(_light.position, _light.position + face_directions[_face][0], face_directions[_face][1]);
+}
@@ -0,0 +1,124 @@
+// Shadows of the most important point lights, each cube face being a square tile of a single large depth texture
+// Each shadowed light has a set of tiles, sized by its importance (how large it looks from the camera) and allocated wherever the atlas is free
+// Sets never move, so that camera motion doesn't throw their contents away: a light only gets a new set when its size changes, and keeps the old one until the new one is rendered
+// Only a few tiles are re-rendered every frame, so that the shadow cost is bounded however many lights there are: those a dynamic caster moved in or out of first, then those that were never rendered, then the least recently rendered ones
+
+#pragma once
+
+#include <span>
+#include <bitset>
+#include <vector>
+#include <cstdint>
+#include "glad/glad.h"
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "Camera.h"
+#include "ClusteredLights.h"
+#include "Utility/Bounds.hpp"
+
+class ShadowAtlas {
+public:
+    struct Tile {
+    public:
+        size_t light = 0; // index into the lights given to Update
+        int face = 0; // +X, -X, +Y, -Y, +Z & -Z
+        glm::ivec2 offset = glm::ivec2(0); // in atlas texels
+        int size = 0;
+        uint32_t first_unit = 0; // of the minimum sized tiles it covers, along the Z-order curve
+
+        glm::mat4 view_projection = glm::mat4(1.0f); // the tile is stale once its light's view of the face changed
+        float importance = 0.0f;
+
+        int64_t last_update = -1; // frame it was last rendered in, -1 if it never was
+        bool dirty = false; // a dynamic caster moved in its view since it was rendered
+    };
+
+    // Counters of the last update (for profiling purposes)
+    struct Stats {
+    public:
+        int shadowed_lights = 0; // with every face rendered at least once
+        int tiles = 0;
+        int updated_tiles = 0;
+        int pending_tiles = 0; // never rendered yet, their lights being unshadowed until they are
+        int stale_tiles = 0; // dirty, but past the budget, so left for a later frame
+        int dropped_lights = 0; // important enough, but past MAX_SHADOWED_LIGHTS or what the atlas can hold
+        int replaced_sets = 0; // kept for their light until the set of its new size is rendered
+
+        // since startup
+        int allocated_sets = 0;
+        int failed_allocations = 0; // the atlas was too fragmented, the light keeping what it had until a later frame
+    };
+
+    inline constexpr static int ATLAS_SIZE = 4096;
+    inline constexpr static int MIN_TILE_SIZE = 128;
+    inline constexpr static int MAX_TILE_SIZE = 512;
+    inline constexpr static float TILE_SIZE_SCALE = 1024.0f; // tile size of a light that looks as large as it is far (before clamping)
+    inline constexpr static float TILE_SIZE_HYSTERESIS = 0.25f; // how far past its size's range (relatively) a light's importance has to go before it is given another size
+    inline constexpr static int UNIT_COUNT = (ATLAS_SIZE / MIN_TILE_SIZE) * (ATLAS_SIZE / MIN_TILE_SIZE); // minimum sized tiles the atlas holds
+
+    inline constexpr static int FACE_COUNT = 6;
+    inline constexpr static int MAX_SHADOWED_LIGHTS = 16;
+    inline constexpr static int MAX_TILES = 2 * MAX_SHADOWED_LIGHTS * FACE_COUNT; // a light may have a set being replaced & its replacement
+    inline constexpr static float SHADOWED_LIGHT_RANK_BIAS = 1.25f; // lights that already have tiles rank as if they were this much more important
+    inline constexpr static float NEAR_PLANE = 0.05f; // the far plane is each light's radius, past which it doesn't light anything
+    inline constexpr static float DEPTH_BIAS = 0.002f; // in the tiles' depth range
+
+    // texture units of the atlas & the tiles' buffer texture, right after the exponential shadow maps
+    inline constexpr static int ATLAS_UNIT = 6;
+    inline constexpr static int TILES_UNIT = 7;
+
+    // has to match the lit shaders' lookups: the tile's view projection, then its offset & size in atlas uvs, and its depth bias
+    inline constexpr static int TILE_TEXELS = 5;
+
+    int update_budget = 8; // tiles rendered per frame
+
+private:
+    GLuint atlas_fbo = 0;
+    GLuint atlas_tex = 0;
+    GLuint tiles_buffer_o = 0, tiles_tex = 0; // TILE_TEXELS RGBA32F texels per tile
+
+    int64_t frame = 0;
+
+    std::vector<Tile> tiles; // FACE_COUNT consecutive tiles per set, a light's sets in the order they were allocated
+    std::bitset<UNIT_COUNT> used_units; // minimum sized tiles covered by a tile, along the Z-order curve
+    std::vector<int> scheduled_tiles;
+
+    // scratch storage of every update
+    std::vector<std::pair<float, size_t>> candidates;
+    std::vector<uint8_t> has_tiles; // per light
+    std::vector<int> tile_sizes;
+    std::vector<int> tile_order;
+    std::vector<glm::vec4> tile_texels;
+
+public:
+    Stats stats;
+
+public:
+    ShadowAtlas();
+    ~ShadowAtlas();
+
+    ShadowAtlas(const ShadowAtlas &) = delete;
+    ShadowAtlas &operator=(const ShadowAtlas &) = delete;
+
+    // picks the lights to shadow & the tiles to render this frame, marks the lights whose tiles are ready & uploads them
+    void Update(std::span<ClusteredLights::PointLight> _lights, const Camera &_camera, bool _enabled);
+    void Bind() const; // binds the atlas & the tiles' buffer texture to their units
+    void InvalidateBounds(const Bounds &_worldBounds); // marks the tiles that see these bounds dirty, so that they are rendered before the others
+
+    [[nodiscard]] GLuint GetFramebuffer() const { return atlas_fbo; }
+    [[nodiscard]] std::span<const int> GetScheduledTiles() const { return scheduled_tiles; } // tiles to render this frame
+    [[nodiscard]] const Tile &GetTile(int _index) const { return tiles[_index]; }
+
+private:
+    void Allocate(std::span<const ClusteredLights::PointLight> _lights); // gives every candidate a set of its tile size, unless it already has one
+    bool AllocateSet(const ClusteredLights::PointLight &_light, size_t _lightIndex, int _tileSize); // appends a set, returns false if there's no room left for it
+    void FreeSet(size_t _firstTile);
+    [[nodiscard]] int FindNewestSet(size_t _light, bool _ready) const; // first tile of the light's last allocated (and fully rendered, if asked for) set, -1 if there's none
+    [[nodiscard]] bool IsReady(size_t _firstTile) const; // every face of the set was rendered at least once
+    void Schedule();
+    void Upload();
+
+    [[nodiscard]] static glm::ivec2 GetZOrderPosition(uint32_t _index); // of a minimum sized tile, in minimum sized tiles
+    [[nodiscard]] static glm::mat4 GetFaceViewProjection(const ClusteredLights::PointLight &_light, int _face);
+};
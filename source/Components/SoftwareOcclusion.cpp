@@ -0,0 +1,378 @@
+#include "SoftwareOcclusion.h"
+
+#include <array>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include "glm/common.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SOFTWARE_OCCLUSION_SSE 1
+#endif
+
+SoftwareOcclusion::SoftwareOcclusion() {
+    depth.resize(WIDTH * HEIGHT, 1.0f);
+    tile_max_depth.resize(TILES_X * TILES_Y, 1.0f);
+
+    parallel = std::thread::hardware_concurrency() > 1;
+}
+
+SoftwareOcclusion::~SoftwareOcclusion() {
+    {
+        std::lock_guard lock(worker_mutex);
+        stopping_workers = true;
+    }
+
+    work_ready.notify_all();
+
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void SoftwareOcclusion::ClearOccluders() {
+    occluder_vertices.clear();
+    stats.occluder_triangles = 0;
+}
+
+void SoftwareOcclusion::AddOccluderBox(const Bounds &_localBounds, const glm::mat4 &_transform) {
+    if (_localBounds.IsEmpty())
+        return;
+
+    // corners are indexed by their max bits (1 for x, 2 for y, 4 for z), each face being a loop of 4 of them
+    constexpr int faces[6][4] = {
+            {0, 2, 6, 4}, {1, 3, 7, 5}, // -x, +x
+            {0, 1, 5, 4}, {2, 3, 7, 6}, // -y, +y
+            {0, 1, 3, 2}, {4, 5, 7, 6}, // -z, +z
+    };
+
+    std::array<glm::vec3, 8> corners = _localBounds.Corners();
+
+    for (auto &corner : corners)
+        corner = glm::vec3(_transform * glm::vec4(corner, 1.0f));
+
+    for (const auto &face : faces) {
+        occluder_vertices.insert(occluder_vertices.end(), {corners[face[0]], corners[face[1]], corners[face[2]]});
+        occluder_vertices.insert(occluder_vertices.end(), {corners[face[0]], corners[face[2]], corners[face[3]]});
+    }
+
+    stats.occluder_triangles += 12;
+}
+
+void SoftwareOcclusion::Rasterize(const glm::mat4 &_viewProjection) {
+    const auto rasterization_start_time = std::chrono::steady_clock::now();
+
+    view_projection = _viewProjection;
+
+    stats.tested_bounds = 0;
+    stats.occluded_bounds = 0;
+
+    SetupTriangles();
+    RasterizeBands();
+
+    stats.rasterization_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - rasterization_start_time).count();
+}
+
+bool SoftwareOcclusion::IsOccluded(const Bounds &_worldBounds) {
+    ++stats.tested_bounds;
+
+    if (_worldBounds.IsEmpty())
+        return false;
+
+    glm::vec3 screen_min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 screen_max = glm::vec3(std::numeric_limits<float>::lowest());
+
+    for (const auto &corner : _worldBounds.Corners()) {
+        const glm::vec4 clip_corner = view_projection * glm::vec4(corner, 1.0f);
+
+        // a box crossing the near plane can't be projected as a whole, but it's right in front of the camera anyway
+        if (clip_corner.w <= 0.0f || clip_corner.z < -clip_corner.w)
+            return false;
+
+        const glm::vec3 screen_corner = ToScreen(clip_corner);
+        screen_min = glm::min(screen_min, screen_corner);
+        screen_max = glm::max(screen_max, screen_corner);
+    }
+
+    // every pixel the box's screen rectangle touches, with the box's nearest depth
+    const int min_x = std::max(0, (int)glm::floor(screen_min.x)), max_x = std::min(WIDTH - 1, (int)glm::floor(screen_max.x));
+    const int min_y = std::max(0, (int)glm::floor(screen_min.y)), max_y = std::min(HEIGHT - 1, (int)glm::floor(screen_max.y));
+    const float nearest_depth = screen_min.z;
+
+    // off screen, which is left to the camera culling
+    if (min_x > max_x || min_y > max_y)
+        return false;
+
+    for (int tile_y = min_y / TILE_SIZE; tile_y <= max_y / TILE_SIZE; ++tile_y) {
+        for (int tile_x = min_x / TILE_SIZE; tile_x <= max_x / TILE_SIZE; ++tile_x) {
+            // the whole tile is nearer than the box
+            if (tile_max_depth[tile_y * TILES_X + tile_x] < nearest_depth)
+                continue;
+
+            const int tile_min_y = std::max(min_y, tile_y * TILE_SIZE), tile_max_y = std::min(max_y, tile_y * TILE_SIZE + TILE_SIZE - 1);
+            const int tile_min_x = std::max(min_x, tile_x * TILE_SIZE), tile_max_x = std::min(max_x, tile_x * TILE_SIZE + TILE_SIZE - 1);
+
+            for (int y = tile_min_y; y <= tile_max_y; ++y) {
+                for (int x = tile_min_x; x <= tile_max_x; ++x) {
+                    if (depth[y * WIDTH + x] >= nearest_depth)
+                        return false;
+                }
+            }
+        }
+    }
+
+    ++stats.occluded_bounds;
+
+    return true;
+}
+
+void SoftwareOcclusion::SetupTriangles() {
+    screen_triangles.clear();
+
+    for (size_t i = 0; i + 2 < occluder_vertices.size(); i += 3) {
+        const glm::vec4 clip_vertices[3] = {
+                view_projection * glm::vec4(occluder_vertices[i], 1.0f),
+                view_projection * glm::vec4(occluder_vertices[i + 1], 1.0f),
+                view_projection * glm::vec4(occluder_vertices[i + 2], 1.0f),
+        };
+
+        ClipAndAdd(clip_vertices);
+    }
+
+    stats.rasterized_triangles = (int)screen_triangles.size();
+}
+
+void SoftwareOcclusion::ClipAndAdd(const glm::vec4 (&_clipVertices)[3]) {
+    // signed distances to the near plane (z = -w), positive in front of it
+    float distances[3];
+    int inside_count = 0;
+
+    for (int i = 0; i < 3; ++i) {
+        distances[i] = _clipVertices[i].z + _clipVertices[i].w;
+        inside_count += distances[i] >= 0.0f;
+    }
+
+    if (inside_count == 0)
+        return;
+
+    if (inside_count == 3) {
+        AddScreenTriangle(_clipVertices[0], _clipVertices[1], _clipVertices[2]);
+        return;
+    }
+
+    // Sutherland-Hodgman against the near plane only, which leaves at most a quad
+    glm::vec4 polygon[4];
+    int polygon_size = 0;
+
+    for (int i = 0; i < 3; ++i) {
+        const int next = (i + 1) % 3;
+
+        if (distances[i] >= 0.0f)
+            polygon[polygon_size++] = _clipVertices[i];
+
+        if ((distances[i] >= 0.0f) != (distances[next] >= 0.0f)) {
+            const float t = distances[i] / (distances[i] - distances[next]);
+            polygon[polygon_size++] = _clipVertices[i] + (_clipVertices[next] - _clipVertices[i]) * t;
+        }
+    }
+
+    for (int i = 1; i + 1 < polygon_size; ++i)
+        AddScreenTriangle(polygon[0], polygon[i], polygon[i + 1]);
+}
+
+void SoftwareOcclusion::AddScreenTriangle(const glm::vec4 &_a, const glm::vec4 &_b, const glm::vec4 &_c) {
+    ScreenTriangle triangle;
+    triangle.vertices[0] = ToScreen(_a);
+    triangle.vertices[1] = ToScreen(_b);
+    triangle.vertices[2] = ToScreen(_c);
+
+    const float min_y = glm::min(triangle.vertices[0].y, glm::min(triangle.vertices[1].y, triangle.vertices[2].y));
+    const float max_y = glm::max(triangle.vertices[0].y, glm::max(triangle.vertices[1].y, triangle.vertices[2].y));
+
+    triangle.min_y = std::max(0, (int)glm::floor(min_y));
+    triangle.max_y = std::min(HEIGHT - 1, (int)glm::floor(max_y));
+
+    if (triangle.min_y > triangle.max_y)
+        return;
+
+    screen_triangles.push_back(triangle);
+}
+
+void SoftwareOcclusion::RasterizeBands() {
+    if (!parallel || screen_triangles.size() < PARALLEL_MIN_TRIANGLES) {
+        for (int band = 0; band < BAND_COUNT; ++band)
+            RasterizeBand(band);
+
+        stats.rasterization_threads = 1;
+        return;
+    }
+
+    if (workers.empty()) {
+        for (int band = 1; band < BAND_COUNT; ++band)
+            workers.emplace_back(&SoftwareOcclusion::WorkerLoop, this, band);
+    }
+
+    // bands never share a pixel nor a tile, so they don't need any synchronization between them
+    {
+        std::lock_guard lock(worker_mutex);
+        pending_bands = BAND_COUNT - 1;
+        ++work_generation;
+    }
+
+    work_ready.notify_all();
+
+    RasterizeBand(0);
+
+    {
+        std::unique_lock lock(worker_mutex);
+        work_done.wait(lock, [this] { return pending_bands == 0; });
+    }
+
+    stats.rasterization_threads = BAND_COUNT;
+    ++stats.parallel_rasterizations;
+}
+
+void SoftwareOcclusion::WorkerLoop(int _band) {
+    uint64_t done_generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock lock(worker_mutex);
+            work_ready.wait(lock, [&] { return stopping_workers || work_generation != done_generation; });
+
+            if (stopping_workers)
+                return;
+
+            done_generation = work_generation;
+        }
+
+        RasterizeBand(_band);
+
+        {
+            std::lock_guard lock(worker_mutex);
+
+            if (--pending_bands == 0)
+                work_done.notify_one();
+        }
+    }
+}
+
+void SoftwareOcclusion::RasterizeBand(int _band) {
+    const int band_min_y = _band * BAND_HEIGHT;
+    const int band_max_y = band_min_y + BAND_HEIGHT - 1;
+
+    std::fill(depth.begin() + band_min_y * WIDTH, depth.begin() + (band_max_y + 1) * WIDTH, 1.0f);
+
+    for (const auto &triangle : screen_triangles) {
+        if (triangle.max_y < band_min_y || triangle.min_y > band_max_y)
+            continue;
+
+        RasterizeTriangle(triangle, std::max(band_min_y, triangle.min_y), std::min(band_max_y, triangle.max_y));
+    }
+
+    UpdateTiles(_band);
+}
+
+void SoftwareOcclusion::RasterizeTriangle(const ScreenTriangle &_triangle, int _minY, int _maxY) {
+    glm::vec3 v0 = _triangle.vertices[0], v1 = _triangle.vertices[1], v2 = _triangle.vertices[2];
+
+    // occluders hide what's behind them from both sides, so clockwise triangles are only flipped, not culled
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+
+    if (area == 0.0f)
+        return;
+
+    if (area < 0.0f) {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    const int min_x = std::max(0, (int)glm::floor(glm::min(v0.x, glm::min(v1.x, v2.x))));
+    const int max_x = std::min(WIDTH - 1, (int)glm::floor(glm::max(v0.x, glm::max(v1.x, v2.x))));
+
+    if (min_x > max_x)
+        return;
+
+    // edge functions (a * x + b * y + c), positive inside of the triangle
+    const glm::vec3 edges[3] = {
+            {v0.y - v1.y, v1.x - v0.x, v0.x * v1.y - v0.y * v1.x},
+            {v1.y - v2.y, v2.x - v1.x, v1.x * v2.y - v1.y * v2.x},
+            {v2.y - v0.y, v0.x - v2.x, v2.x * v0.y - v2.y * v0.x},
+    };
+
+    // depth is affine in screen space, as a plane through the 3 vertices
+    const float depth_dx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+    const float depth_dy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+
+    // rows start on a multiple of 4 pixels, so that every group of 4 stays in the row (WIDTH being a multiple of 4 too)
+    const int start_x = min_x & ~3;
+
+    for (int y = _minY; y <= _maxY; ++y) {
+        const float pixel_y = (float)y + 0.5f;
+        float *row = &depth[y * WIDTH];
+
+        const float edge_rows[3] = {
+                edges[0].y * pixel_y + edges[0].z,
+                edges[1].y * pixel_y + edges[1].z,
+                edges[2].y * pixel_y + edges[2].z,
+        };
+        const float depth_row = v0.z + depth_dy * (pixel_y - v0.y) - depth_dx * v0.x;
+
+#if SOFTWARE_OCCLUSION_SSE
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 lane_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+        for (int x = start_x; x <= max_x; x += 4) {
+            const __m128 pixel_x = _mm_add_ps(_mm_set1_ps((float)x), lane_offsets);
+
+            const __m128 edge0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edges[0].x), pixel_x), _mm_set1_ps(edge_rows[0]));
+            const __m128 edge1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edges[1].x), pixel_x), _mm_set1_ps(edge_rows[1]));
+            const __m128 edge2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edges[2].x), pixel_x), _mm_set1_ps(edge_rows[2]));
+
+            const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+
+            if (_mm_movemask_ps(inside) == 0)
+                continue;
+
+            const __m128 pixel_depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depth_dx), pixel_x), _mm_set1_ps(depth_row));
+            const __m128 current_depth = _mm_loadu_ps(row + x);
+            const __m128 nearest_depth = _mm_min_ps(current_depth, pixel_depth);
+
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest_depth), _mm_andnot_ps(inside, current_depth)));
+        }
+#else
+        for (int x = start_x; x <= max_x; ++x) {
+            const float pixel_x = (float)x + 0.5f;
+
+            if (edges[0].x * pixel_x + edge_rows[0] < 0.0f || edges[1].x * pixel_x + edge_rows[1] < 0.0f || edges[2].x * pixel_x + edge_rows[2] < 0.0f)
+                continue;
+
+            row[x] = glm::min(row[x], depth_dx * pixel_x + depth_row);
+        }
+#endif
+    }
+}
+
+void SoftwareOcclusion::UpdateTiles(int _band) {
+    const int band_min_tile_y = _band * BAND_HEIGHT / TILE_SIZE;
+    const int band_max_tile_y = band_min_tile_y + BAND_HEIGHT / TILE_SIZE - 1;
+
+    for (int tile_y = band_min_tile_y; tile_y <= band_max_tile_y; ++tile_y) {
+        for (int tile_x = 0; tile_x < TILES_X; ++tile_x) {
+            float max_depth = 0.0f;
+
+            for (int y = tile_y * TILE_SIZE; y < (tile_y + 1) * TILE_SIZE; ++y) {
+                const float *row = &depth[y * WIDTH + tile_x * TILE_SIZE];
+                max_depth = glm::max(max_depth, *std::max_element(row, row + TILE_SIZE));
+            }
+
+            tile_max_depth[tile_y * TILES_X + tile_x] = max_depth;
+        }
+    }
+}
+
+glm::vec3 SoftwareOcclusion::ToScreen(const glm::vec4 &_clipVertex) {
+    const glm::vec3 ndc = glm::vec3(_clipVertex) / _clipVertex.w;
+
+    return {(ndc.x * 0.5f + 0.5f) * (float)WIDTH, (ndc.y * 0.5f + 0.5f) * (float)HEIGHT, ndc.z * 0.5f + 0.5f};
+}
@@ -0,0 +1,101 @@
+// Low resolution depth buffer of a few large occluders, rasterized on the CPU, so that objects hidden behind them are known before they're even pushed (no GPU readback, no latency)
+// The depth buffer is hierarchical: each tile also keeps its furthest depth, so that most tests never need to look at single pixels
+// Rows are split into bands that are rasterized independently (SSE, 4 pixels at once), on persistent worker threads once there are enough triangles for it to pay off
+
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "Utility/Bounds.hpp"
+
+class SoftwareOcclusion {
+public:
+    // Counters (for profiling purposes)
+    struct Stats {
+    public:
+        int occluder_triangles = 0;
+
+        // since the last rasterization
+        int rasterized_triangles = 0; // once clipped by the near plane, in screen space
+        int tested_bounds = 0;
+        int occluded_bounds = 0;
+        double rasterization_ms = 0.0;
+        int rasterization_threads = 1; // 1 when every band was rasterized on the calling thread
+
+        int parallel_rasterizations = 0; // since startup
+    };
+
+    inline constexpr static int WIDTH = 256;
+    inline constexpr static int HEIGHT = 128;
+    inline constexpr static int TILE_SIZE = 8; // in pixels, per side
+    inline constexpr static int TILES_X = WIDTH / TILE_SIZE;
+    inline constexpr static int TILES_Y = HEIGHT / TILE_SIZE;
+
+    inline constexpr static int BAND_COUNT = 4; // whole rows of tiles each
+    inline constexpr static int BAND_HEIGHT = HEIGHT / BAND_COUNT;
+    // rasterization is bound by the pixels the triangles cover (the ground & the world cube alone cover most of the screen), not by their count
+    // so even a handful of them is worth splitting across cores, as long as there's more than one
+    inline constexpr static size_t PARALLEL_MIN_TRIANGLES = 16;
+
+private:
+    struct ScreenTriangle {
+    public:
+        glm::vec3 vertices[3]; // in pixels, with the depth in [0, 1]
+        int min_y, max_y; // rows covered, clamped to the screen
+    };
+
+    std::vector<glm::vec3> occluder_vertices; // world space triangle list
+
+    std::vector<float> depth; // WIDTH * HEIGHT, bottom row first
+    std::vector<float> tile_max_depth; // TILES_X * TILES_Y, furthest depth of each tile
+
+    glm::mat4 view_projection = glm::mat4(1.0f);
+
+    // scratch storage of the rasterization
+    std::vector<ScreenTriangle> screen_triangles;
+
+    // one per band past the first (which the calling thread rasterizes), only started by the first parallel rasterization & parked in between
+    std::vector<std::thread> workers;
+    std::mutex worker_mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    uint64_t work_generation = 0; // bumped for every parallel rasterization, so that each worker knows when there's a new one
+    int pending_bands = 0;
+    bool stopping_workers = false;
+    bool parallel = false; // whether there's more than one hardware thread to rasterize on
+
+public:
+    Stats stats;
+
+public:
+    SoftwareOcclusion();
+    ~SoftwareOcclusion();
+
+    SoftwareOcclusion(const SoftwareOcclusion &) = delete;
+    SoftwareOcclusion &operator=(const SoftwareOcclusion &) = delete;
+
+    void ClearOccluders();
+    void AddOccluderBox(const Bounds &_localBounds, const glm::mat4 &_transform); // its 12 triangles, both sides of them hiding what's behind
+
+    void Rasterize(const glm::mat4 &_viewProjection); // to be called once per frame, before any test
+    bool IsOccluded(const Bounds &_worldBounds); // whether the box is entirely behind the occluders, conservatively
+
+private:
+    void SetupTriangles(); // projects & clips the occluders by the near plane into screen_triangles
+    void ClipAndAdd(const glm::vec4 (&_clipVertices)[3]);
+    void AddScreenTriangle(const glm::vec4 &_a, const glm::vec4 &_b, const glm::vec4 &_c);
+
+    void RasterizeBands(); // every band, on the workers as well if there are enough triangles
+    void RasterizeBand(int _band);
+    void WorkerLoop(int _band);
+    void RasterizeTriangle(const ScreenTriangle &_triangle, int _minY, int _maxY);
+    void UpdateTiles(int _band);
+
+    [[nodiscard]] static glm::vec3 ToScreen(const glm::vec4 &_clipVertex);
+};
@@ -0,0 +1,96 @@
+#include "VisualBakedModel.h"
+#include "Components/GLStateCache.h"
+
+#include <utility>
+#include "glm/mat3x3.hpp"
+#include "glm/matrix.hpp"
+
+VisualBakedModel::VisualBakedModel(const Mesh &_sourceMesh, std::span<const glm::mat4> _partTransforms, Shader::Material _material) : VisualObject(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), std::move(_material))
+{
+    vertex_stride = _sourceMesh.vertex_stride;
+
+    // a chain of levels of detail (e.g. a sphere's) shares its buffers, each level's indices being relative to its own base vertex, so it can't be flattened as a whole
+    if (!_sourceMesh.lods.empty())
+    {
+        std::cout << "ERROR::VISUAL_BAKED_MODEL::UNSUPPORTED_LOD_CHAIN" << std::endl;
+        return;
+    }
+
+    vertices.reserve(_sourceMesh.vertices.size() * _partTransforms.size());
+    indices.reserve(_sourceMesh.indices.size() * _partTransforms.size());
+
+    for (const auto &part_transform : _partTransforms)
+    {
+        // normals don't follow non-uniform scales, so they go through the inverse transpose instead
+        const auto normal_matrix = glm::transpose(glm::inverse(glm::mat3(part_transform)));
+        const auto index_offset = (int)(vertices.size() / vertex_stride);
+
+        for (size_t i = 0; i < _sourceMesh.vertices.size(); i += vertex_stride)
+        {
+            const auto position = glm::vec3(part_transform * glm::vec4(_sourceMesh.vertices[i], _sourceMesh.vertices[i + 1], _sourceMesh.vertices[i + 2], 1.0f));
+            const auto normal = glm::normalize(normal_matrix * glm::vec3(_sourceMesh.vertices[i + 3], _sourceMesh.vertices[i + 4], _sourceMesh.vertices[i + 5]));
+
+            vertices.insert(vertices.end(), {position.x, position.y, position.z, normal.x, normal.y, normal.z});
+
+            // anything after the normal (e.g. uvs) is copied as is
+            vertices.insert(vertices.end(), _sourceMesh.vertices.begin() + (long)i + 6, _sourceMesh.vertices.begin() + (long)i + vertex_stride);
+        }
+
+        for (const auto index : _sourceMesh.indices)
+            indices.push_back(index + index_offset);
+    }
+
+    // only the layouts of the library's single-level meshes are supported (i.e. cubes)
+    if (vertex_stride == 6 && indices.empty())
+        SetupGlBuffersVerticesAndNormalsOnlyNoIndices();
+    else if (vertex_stride == 8 && !indices.empty())
+        SetupGlBuffersVerticesNormalUv();
+    else
+    {
+        std::cout << "ERROR::VISUAL_BAKED_MODEL::UNSUPPORTED_VERTEX_LAYOUT" << std::endl;
+        return;
+    }
+
+    SetupGlDepthBuffers(vertex_stride);
+}
+
+void VisualBakedModel::Draw(int _renderMode, const Shader::Material *material)
+{
+    DrawFromMatrix(GetModelMatrix(), _renderMode, material);
+}
+
+void VisualBakedModel::DrawFromMatrix(const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
+{
+    // bind the vertex array to draw
+    GLStateCache::BindVertexArray(vertex_array_o);
+
+    const Shader::Material *current_material = &material;
+
+    // set the material to use on this frame
+    if (_material != nullptr)
+        current_material = _material;
+
+    current_material->shader->Use();
+    current_material->shader->SetModelMatrix(_transformMatrix);
+
+    current_material->shader->SetVec3("u_color", current_material->color);
+    current_material->shader->SetFloat("u_alpha", current_material->alpha);
+
+    current_material->shader->SetInt("u_shininess", current_material->shininess);
+    current_material->shader->SetInt("u_receives_shadows", current_material->receives_shadows);
+
+    GLStateCache::BindTexture(1, GL_TEXTURE_2D, current_material->texture);
+
+    current_material->shader->SetFloat("u_texture_influence", current_material->texture_influence);
+
+    GLStateCache::LineWidth(current_material->line_thickness);
+    GLStateCache::PointSize(current_material->point_size);
+
+    // every part is drawn at once
+    if (indices.empty())
+        glDrawArrays(_renderMode, 0, (GLsizei)(vertices.size() / vertex_stride));
+    else
+        glDrawElements(_renderMode, (GLsizei)indices.size(), GL_UNSIGNED_INT, nullptr);
+
+    ++draw_calls;
+}
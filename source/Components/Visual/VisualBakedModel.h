@@ -0,0 +1,26 @@
+// For information on how this class (and its parent class) work, see VisualObject.h
+
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+#include "glm/vec3.hpp"
+#include "Components/Shader.h"
+#include "Components/MeshLibrary.h"
+#include "VisualObject.h"
+
+// Many copies of a mesh with fixed relative transforms (e.g. the cubes of a letter), flattened into a single vertex buffer
+// The whole model can still be moved by the transform matrix it is drawn with
+class VisualBakedModel : public VisualObject
+{
+public:
+    // Bakes one copy of the source mesh per part transform
+    VisualBakedModel(const Mesh &_sourceMesh, std::span<const glm::mat4> _partTransforms, Shader::Material _material = Shader::Material());
+
+    void Draw(int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
+    void DrawFromMatrix(const glm::mat4 &_transformMatrix, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
+
+private:
+    int vertex_stride;
+};
@@ -1,4 +1,5 @@
 #include "VisualCube.h"
+#include "Components/GLStateCache.h"
 
 
 #include <utility>
@@ -6,6 +7,12 @@
 
 VisualCube::VisualCube(glm::vec3 _position, glm::vec3 _rotation, glm::vec3 _scale, glm::vec3 _transformOffset, Shader::Material _material) : VisualObject(_position, _rotation, _scale, std::move(_material))
 {
+    // every cube with the same offset has the exact same geometry
+    const MeshLibrary::Key mesh_key = {MeshLibrary::Shape::CUBE, {_transformOffset.x, _transformOffset.y, _transformOffset.z}};
+
+    if (UseInternedMesh(mesh_key))
+        return;
+
     // vertices with their normals
     vertices = {
         // top face, top triangle
@@ -257,22 +264,19 @@ VisualCube::VisualCube(glm::vec3 _position, glm::vec3 _rotation, glm::vec3 _scal
     }
 
     VisualObject::SetupGlBuffersVerticesAndNormalsOnlyNoIndices();
+    VisualObject::SetupGlDepthBuffers(6);
+    InternMesh(mesh_key, 6);
 }
 
-void VisualCube::Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode, const Shader::Material *material)
+void VisualCube::Draw(int _renderMode, const Shader::Material *material)
 {
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, position);
-    model_matrix = Transforms::RotateDegrees(model_matrix, rotation);
-    model_matrix = glm::scale(model_matrix, scale);
-
-    DrawFromMatrix(_viewProjection, _cameraPosition, model_matrix, _renderMode, material);
+    DrawFromMatrix(GetModelMatrix(), _renderMode, material);
 }
 
-void VisualCube::DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
+void VisualCube::DrawFromMatrix(const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
 {
     // bind the vertex array to draw
-    glBindVertexArray(vertex_array_o);
+    GLStateCache::BindVertexArray(vertex_array_o);
 
     const Shader::Material *current_material = &material;
 
@@ -282,34 +286,110 @@ void VisualCube::DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec
 
     current_material->shader->Use();
     current_material->shader->SetModelMatrix(_transformMatrix);
-    current_material->shader->SetViewProjectionMatrix(_viewProjection);
 
     current_material->shader->SetVec3("u_color", current_material->color);
     current_material->shader->SetFloat("u_alpha", current_material->alpha);
 
-    current_material->shader->SetVec3("u_cam_pos", _cameraPosition);
+    current_material->shader->SetInt("u_shininess", current_material->shininess);
+    current_material->shader->SetInt("u_receives_shadows", current_material->receives_shadows);
 
-    current_material->shader->SetVec3("u_light_pos", current_material->main_light->GetPosition());
-    current_material->shader->SetVec3("u_light_color", current_material->main_light->GetColor());
+    GLStateCache::BindTexture(1, GL_TEXTURE_2D, current_material->texture);
 
-    current_material->shader->SetFloat("u_ambient_strength", current_material->main_light->ambient_strength);
-    current_material->shader->SetFloat("u_specular_strength", current_material->main_light->specular_strength);
-    current_material->shader->SetInt("u_shininess", current_material->shininess);
+    current_material->shader->SetFloat("u_texture_influence", current_material->texture_influence);
 
-    current_material->shader->SetFloat("u_shadows_influence", 1.0f - (float)current_material->main_light->project_shadows);
-    current_material->shader->SetMat4("u_light_view_projection", current_material->main_light->GetViewProjection());
-    current_material->shader->SetTexture("u_depth_texture", 0);
+    GLStateCache::LineWidth(current_material->line_thickness);
+    GLStateCache::PointSize(current_material->point_size);
 
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, current_material->texture);
+    // draw vertices (6 floats per vertex: position + normal)
+    glDrawArrays(_renderMode, 0, mesh->VertexCount());
 
-    current_material->shader->SetFloat("u_texture_influence", current_material->texture_influence);
-    current_material->shader->SetTexture("u_texture", 1);
+    ++draw_calls;
+}
+
+void VisualCube::DrawInstanced(std::span<const glm::mat4> _transformMatrices, std::span<const glm::vec3> _colors, int _renderMode, const Shader::Material *_material)
+{
+    const Shader::Material *current_material = &material;
+
+    // set the material to use on this frame
+    if (_material != nullptr)
+        current_material = _material;
+
+    // a program without an instanced variant can't read the per-instance attributes, so we fall back to one draw per instance
+    if (current_material->shader->instanced_variant == nullptr)
+    {
+        VisualObject::DrawInstanced(_transformMatrices, _colors, _renderMode, _material);
+        return;
+    }
+
+    if (_transformMatrices.empty())
+        return;
+
+    // bind the vertex array to draw
+    GLStateCache::BindVertexArray(vertex_array_o);
+
+    if (mesh->instance_buffer_o == 0)
+        SetupGlInstanceBuffer();
+
+    // orphans the previous instance data, so that we don't wait on the previous draw to be done with it
+    const auto transforms_size = (GLsizeiptr)_transformMatrices.size_bytes();
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->instance_buffer_o);
+    glBufferData(GL_ARRAY_BUFFER, transforms_size + (GLsizeiptr)_colors.size_bytes(), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, transforms_size, _transformMatrices.data());
+
+    // colors are packed right after the transforms, otherwise every instance uses the material's color
+    if (!_colors.empty())
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, transforms_size, (GLsizeiptr)_colors.size_bytes(), _colors.data());
+
+        glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid *)transforms_size);
+        glEnableVertexAttribArray(7);
+    }
+    else
+    {
+        glDisableVertexAttribArray(7);
+        glVertexAttrib3f(7, current_material->color.r, current_material->color.g, current_material->color.b);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    const auto &instanced_shader = current_material->shader->instanced_variant;
+
+    instanced_shader->Use();
+
+    instanced_shader->SetFloat("u_alpha", current_material->alpha);
+    instanced_shader->SetInt("u_shininess", current_material->shininess);
+    instanced_shader->SetInt("u_receives_shadows", current_material->receives_shadows);
+
+    GLStateCache::BindTexture(1, GL_TEXTURE_2D, current_material->texture);
+
+    instanced_shader->SetFloat("u_texture_influence", current_material->texture_influence);
+
+    GLStateCache::LineWidth(current_material->line_thickness);
+    GLStateCache::PointSize(current_material->point_size);
+
+    // draw every instance at once
+    glDrawArraysInstanced(_renderMode, 0, mesh->VertexCount(), (GLsizei)_transformMatrices.size());
+
+    ++draw_calls;
+}
+
+void VisualCube::SetupGlInstanceBuffer()
+{
+    // expects the cube's vertex array to be bound
+    glGenBuffers(1, &mesh->instance_buffer_o);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->instance_buffer_o);
+
+    // a mat4 attribute takes 4 consecutive locations (one per column), starting after position, normal & uv
+    for (int i = 0; i < 4; ++i)
+    {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (GLvoid *)(i * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribDivisor(3 + i, 1);
+    }
 
-    glLineWidth(current_material->line_thickness);
-    glPointSize(current_material->point_size);
+    // per-instance color
+    glVertexAttribDivisor(7, 1);
 
-    // draw vertices according to their indices
-    glDrawArrays(_renderMode, 0, vertices.size());
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
@@ -13,6 +13,10 @@ class VisualCube : public VisualObject
 public:
     explicit VisualCube(glm::vec3 _position = glm::vec3(0.0f), glm::vec3 _rotation = glm::vec3(0.0f), glm::vec3 _scale = glm::vec3(1.0f), glm::vec3 _transformOffset = glm::vec3(0.0f), Shader::Material _material = Shader::Material());
 
-    void Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
-    void DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
+    void Draw(int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
+    void DrawFromMatrix(const glm::mat4 &_transformMatrix, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
+    void DrawInstanced(std::span<const glm::mat4> _transformMatrices, std::span<const glm::vec3> _colors, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
+
+private:
+    void SetupGlInstanceBuffer();
 };
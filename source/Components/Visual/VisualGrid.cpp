@@ -1,4 +1,5 @@
 #include "VisualGrid.h"
+#include "Components/GLStateCache.h"
 #include "Utility/Math.hpp"
 #include "Utility/Transform.hpp"
 
@@ -67,23 +68,28 @@ VisualGrid::VisualGrid(int _width, int _height, float _cellSize, glm::vec3 _posi
     }
 
     VisualObject::SetupGlBuffersVerticesOnly();
+    VisualObject::ComputeLocalBounds(3);
 }
 
-void VisualGrid::Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode, const Shader::Material *_material)
+void VisualGrid::Draw(int _renderMode, const Shader::Material *_material)
+{
+    DrawFromMatrix(GetModelMatrix(), _renderMode, _material);
+}
+
+glm::mat4 VisualGrid::GetModelMatrix() const
 {
     glm::mat4 model_matrix = glm::mat4(1.0f);
     model_matrix = glm::scale(model_matrix, glm::vec3((float)width * cell_size / 2, 0.0f, (float)height * cell_size / 2));
     model_matrix = Transforms::RotateDegrees(model_matrix, rotation);
     model_matrix = glm::translate(model_matrix, position);
 
-    DrawFromMatrix(_viewProjection, _cameraPosition, model_matrix, _renderMode, _material);
+    return model_matrix;
 }
 
-void VisualGrid::DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition,
-                                const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
+void VisualGrid::DrawFromMatrix(const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
 {
     // bind the vertex array to draw
-    glBindVertexArray(vertex_array_o);
+    GLStateCache::BindVertexArray(vertex_array_o);
 
     const Shader::Material *current_material = &material;
 
@@ -93,14 +99,15 @@ void VisualGrid::DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec
 
     current_material->shader->Use();
     current_material->shader->SetModelMatrix(_transformMatrix);
-    current_material->shader->SetViewProjectionMatrix(_viewProjection);
 
     current_material->shader->SetVec3("u_color", current_material->color.x, current_material->color.y, current_material->color.z);
     current_material->shader->SetFloat("u_alpha", current_material->alpha);
 
-    glLineWidth(current_material->line_thickness);
-    glPointSize(current_material->point_size);
+    GLStateCache::LineWidth(current_material->line_thickness);
+    GLStateCache::PointSize(current_material->point_size);
 
     // draw vertices according to their indices
     glDrawElements(_renderMode, indices.size(), GL_UNSIGNED_INT, nullptr);
+
+    ++draw_calls;
 }
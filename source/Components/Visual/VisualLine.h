@@ -16,6 +16,8 @@ public:
 public:
     explicit VisualLine(glm::vec3 _start = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 _end = glm::vec3(1.0f, 1.0f, 1.0f), Shader::Material _material = Shader::Material());
 
-    void Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode = GL_LINES, const Shader::Material *_material = nullptr) override;
-    void DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode = GL_LINES, const Shader::Material *_material = nullptr) override;
+    void Draw(int _renderMode = GL_LINES, const Shader::Material *_material = nullptr) override;
+    void DrawFromMatrix(const glm::mat4 &_transformMatrix, int _renderMode = GL_LINES, const Shader::Material *_material = nullptr) override;
+
+    [[nodiscard]] glm::mat4 GetModelMatrix() const override;
 };
@@ -1,6 +1,8 @@
 #include "VisualObject.h"
+#include "Components/GLStateCache.h"
 
 #include <utility>
+#include "Utility/Transform.hpp"
 
 VisualObject::VisualObject(glm::vec3 _position, glm::vec3 _rotation, glm::vec3 _scale, Shader::Material _material) {
     position = _position;
@@ -14,10 +16,157 @@ VisualObject::VisualObject(glm::vec3 _position, glm::vec3 _rotation, glm::vec3 _
     element_buffer_o = 0;
 }
 
+void VisualObject::DrawInstanced(std::span<const glm::mat4> _transformMatrices, std::span<const glm::vec3> _colors, int _renderMode, const Shader::Material *_material) {
+    Shader::Material instance_material = _material != nullptr ? *_material : material;
+
+    for (size_t i = 0; i < _transformMatrices.size(); ++i) {
+        if (i < _colors.size())
+            instance_material.color = _colors[i];
+
+        DrawFromMatrix(_transformMatrices[i], _renderMode, &instance_material);
+    }
+}
+
+void VisualObject::DrawDepth(const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material &_depthMaterial) {
+    if (depth_vertex_array_o == 0) {
+        DrawFromMatrix(_transformMatrix, _renderMode, &_depthMaterial);
+        return;
+    }
+
+    GLStateCache::BindVertexArray(depth_vertex_array_o);
+
+    _depthMaterial.shader->Use();
+    _depthMaterial.shader->SetModelMatrix(_transformMatrix);
+
+    // only matters to racket parts drawn as lines or points
+    GLStateCache::LineWidth(_depthMaterial.line_thickness);
+    GLStateCache::PointSize(_depthMaterial.point_size);
+
+    if (depth_indexed)
+        glDrawElements(_renderMode, depth_element_count, GL_UNSIGNED_INT, nullptr);
+    else
+        glDrawArrays(_renderMode, 0, depth_element_count);
+
+    ++draw_calls;
+}
+
+glm::mat4 VisualObject::GetModelMatrix() const {
+    glm::mat4 model_matrix = glm::mat4(1.0f);
+    model_matrix = glm::translate(model_matrix, position);
+    model_matrix = Transforms::RotateDegrees(model_matrix, rotation);
+    model_matrix = glm::scale(model_matrix, scale);
+
+    return model_matrix;
+}
+
+bool VisualObject::UseInternedMesh(const MeshLibrary::Key &_key) {
+    mesh = MeshLibrary::Find(_key);
+
+    if (mesh == nullptr)
+        return false;
+
+    vertex_array_o = mesh->vertex_array_o;
+    local_bounds = mesh->bounds;
+    local_sphere = mesh->sphere;
+
+    depth_vertex_array_o = mesh->depth_vertex_array_o;
+    depth_indexed = !mesh->indices.empty();
+    depth_element_count = depth_indexed ? mesh->IndexCount() : mesh->VertexCount();
+
+    return true;
+}
+
+void VisualObject::InternMesh(const MeshLibrary::Key &_key, int _vertexStride, std::vector<Mesh::Lod> _lods) {
+    mesh = MeshLibrary::Add(_key, Mesh{
+        .vertices = std::move(vertices),
+        .indices = std::move(indices),
+        .lods = std::move(_lods),
+        .vertex_stride = _vertexStride,
+        .bounds = local_bounds,
+        .sphere = local_sphere,
+        .vertex_array_o = vertex_array_o,
+        .depth_vertex_array_o = depth_vertex_array_o,
+    });
+
+    // the library keeps the only copy of the geometry
+    vertices.clear();
+    indices.clear();
+}
+
+void VisualObject::SetupGlDepthBuffers(int _vertexStride) {
+    // only keeps the positions, so that depth-only passes fetch as little as possible
+    std::vector<float> positions;
+    positions.reserve(vertices.size() / _vertexStride * 3);
+
+    for (size_t i = 0; i < vertices.size(); i += _vertexStride)
+        positions.insert(positions.end(), vertices.begin() + (long)i, vertices.begin() + (long)i + 3);
+
+    ComputeLocalBounds(_vertexStride);
+
+    GLuint position_buffer_o = 0;
+    GLuint depth_element_buffer_o = 0;
+
+    //generate and bind the depth vertex array (VAO)
+    glGenVertexArrays(1, &depth_vertex_array_o);
+    GLStateCache::BindVertexArray(depth_vertex_array_o);
+
+    //generate and bind the positions' VBO
+    glGenBuffers(1, &position_buffer_o);
+    glBindBuffer(GL_ARRAY_BUFFER, position_buffer_o);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float),
+                 &positions.front(), GL_STATIC_DRAW);
+
+    //generate and bind the EBO, if there are indices to share
+    depth_indexed = !indices.empty();
+
+    if (depth_indexed) {
+        glGenBuffers(1, &depth_element_buffer_o);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, depth_element_buffer_o);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(int),
+                     &indices.front(), GL_STATIC_DRAW);
+    }
+
+    //set vertex attributes pointers (position)
+    //strides are 3 * float-size long, because only positions are kept
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (GLvoid *) nullptr);
+    glEnableVertexAttribArray(0);
+
+    //cleanup buffers
+    GLStateCache::BindVertexArray(0);
+    glDeleteBuffers(1, &position_buffer_o);
+
+    if (depth_indexed)
+        glDeleteBuffers(1, &depth_element_buffer_o);
+
+    depth_element_count = depth_indexed ? (GLsizei)indices.size() : (GLsizei)(positions.size() / 3);
+}
+
+void VisualObject::ComputeLocalBounds(int _vertexStride) {
+    local_bounds = Bounds();
+
+    for (size_t i = 0; i < vertices.size(); i += _vertexStride)
+        local_bounds.Add(glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]));
+
+    // centered on the box, but only as large as the furthest vertex (tighter than the box's own sphere for rounded shapes)
+    local_sphere = BoundingSphere::Around(local_bounds);
+
+    if (local_sphere.IsEmpty())
+        return;
+
+    float max_distance_squared = 0.0f;
+
+    for (size_t i = 0; i < vertices.size(); i += _vertexStride) {
+        const glm::vec3 offset = glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]) - local_sphere.center;
+        max_distance_squared = glm::max(max_distance_squared, glm::dot(offset, offset));
+    }
+
+    local_sphere.radius = glm::sqrt(max_distance_squared);
+}
+
 void VisualObject::SetupGlBuffersVerticesOnly() {
     //generate and bind the circles' vertex array (VAO)
     glGenVertexArrays(1, &vertex_array_o);
-    glBindVertexArray(vertex_array_o);
+    GLStateCache::BindVertexArray(vertex_array_o);
 
     //generate and bind the grid's VBO
     glGenBuffers(1, &vertex_buffer_o);
@@ -40,7 +189,7 @@ void VisualObject::SetupGlBuffersVerticesOnly() {
     //more info: https://learnopengl.com/code_viewer_gh.php?code=src/1.getting_started/2.2.hello_triangle_indexed/hello_triangle_indexed.cpp
 
     //cleanup buffers
-    glBindVertexArray(0);
+    GLStateCache::BindVertexArray(0);
     glDeleteBuffers(1, &vertex_buffer_o);
     glDeleteBuffers(1, &element_buffer_o);
 }
@@ -48,7 +197,7 @@ void VisualObject::SetupGlBuffersVerticesOnly() {
 void VisualObject::SetupGlBuffersVerticesAndUvsOnly() {
     //generate and bind the circles' vertex array (VAO)
     glGenVertexArrays(1, &vertex_array_o);
-    glBindVertexArray(vertex_array_o);
+    GLStateCache::BindVertexArray(vertex_array_o);
 
     //generate and bind the grid's VBO
     glGenBuffers(1, &vertex_buffer_o);
@@ -74,7 +223,7 @@ void VisualObject::SetupGlBuffersVerticesAndUvsOnly() {
     //more info: https://learnopengl.com/code_viewer_gh.php?code=src/1.getting_started/2.2.hello_triangle_indexed/hello_triangle_indexed.cpp
 
     //cleanup buffers
-    glBindVertexArray(0);
+    GLStateCache::BindVertexArray(0);
     glDeleteBuffers(1, &vertex_buffer_o);
     glDeleteBuffers(1, &element_buffer_o);
 }
@@ -82,7 +231,7 @@ void VisualObject::SetupGlBuffersVerticesAndUvsOnly() {
 void VisualObject::SetupGlBuffersVerticesNormalUv(){
     //generate and bind the circles' vertex array (VAO)
     glGenVertexArrays(1, &vertex_array_o);
-    glBindVertexArray(vertex_array_o);
+    GLStateCache::BindVertexArray(vertex_array_o);
 
     //generate and bind the grid's VBO
     glGenBuffers(1, &vertex_buffer_o);
@@ -111,7 +260,7 @@ void VisualObject::SetupGlBuffersVerticesNormalUv(){
     //more info: https://learnopengl.com/code_viewer_gh.php?code=src/1.getting_started/2.2.hello_triangle_indexed/hello_triangle_indexed.cpp
 
     //cleanup buffers
-    glBindVertexArray(0);
+    GLStateCache::BindVertexArray(0);
     glDeleteBuffers(1, &vertex_buffer_o);
     glDeleteBuffers(1, &element_buffer_o);
 }
@@ -119,7 +268,7 @@ void VisualObject::SetupGlBuffersVerticesNormalUv(){
 void VisualObject::SetupGlBuffersVerticesAndNormalsOnlyNoIndices() {
     //generate and bind the circles' vertex array (VAO)
     glGenVertexArrays(1, &vertex_array_o);
-    glBindVertexArray(vertex_array_o);
+    GLStateCache::BindVertexArray(vertex_array_o);
 
     //generate and bind the grid's VBO
     glGenBuffers(1, &vertex_buffer_o);
@@ -140,6 +289,6 @@ void VisualObject::SetupGlBuffersVerticesAndNormalsOnlyNoIndices() {
     //more info: https://learnopengl.com/code_viewer_gh.php?code=src/1.getting_started/2.2.hello_triangle_indexed/hello_triangle_indexed.cpp
 
     //cleanup buffers
-    glBindVertexArray(0);
+    GLStateCache::BindVertexArray(0);
     glDeleteBuffers(1, &vertex_buffer_o);
 }
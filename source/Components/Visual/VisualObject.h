@@ -2,8 +2,10 @@
 
 #include <memory>
 #include <vector>
+#include <span>
 #include "glm/vec3.hpp"
 #include "Components/Shader.h"
+#include "Components/MeshLibrary.h"
 
 class VisualObject
 {
@@ -25,13 +27,52 @@ protected:
     GLuint vertex_buffer_o;
     GLuint element_buffer_o;
 
+    // Position-only copy of the geometry, for depth-only passes (0 if this object has none)
+    GLuint depth_vertex_array_o = 0;
+    GLsizei depth_element_count = 0;
+    bool depth_indexed = false;
+
+    // Bounds of the geometry, in the object's own space (empty until its geometry is built)
+    Bounds local_bounds;
+    BoundingSphere local_sphere;
+
+    // Geometry shared with other objects of the same shape & parameters (nullptr if this object owns its geometry)
+    std::shared_ptr<const Mesh> mesh = nullptr;
+
+public:
+    // Number of draw calls issued by all objects since it was last reset (for profiling purposes)
+    inline static int draw_calls = 0;
+
 public:
     explicit VisualObject(glm::vec3 _position = glm::vec3(0.0f), glm::vec3 _rotation = glm::vec3(0.0f), glm::vec3 _scale = glm::vec3(1.0f), Shader::Material _material = Shader::Material());
 
-    virtual void Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int render_mode, const Shader::Material *_material) = 0;
-    virtual void DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material) = 0;
+    virtual void Draw(int render_mode, const Shader::Material *_material) = 0;
+    virtual void DrawFromMatrix(const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material) = 0;
+
+    // Draws this object once per transform matrix
+    // _colors is either empty (the material's color is used) or holds one color per transform matrix
+    // By default, every instance is drawn on its own, subclasses can override this with a single instanced draw
+    virtual void DrawInstanced(std::span<const glm::mat4> _transformMatrices, std::span<const glm::vec3> _colors, int _renderMode, const Shader::Material *_material);
+
+    // Draws this object's depth only (e.g. into a shadow map), with the position-only vertex stream
+    // Only the transform is set on the depth material's shader, objects without a position-only stream fall back to DrawFromMatrix
+    virtual void DrawDepth(const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material &_depthMaterial);
+
+    // Transform matrix used by Draw, built from this object's transform properties
+    [[nodiscard]] virtual glm::mat4 GetModelMatrix() const;
+    [[nodiscard]] GLuint GetVertexArray() const { return vertex_array_o; }
+    [[nodiscard]] GLuint GetDepthVertexArray() const { return depth_vertex_array_o != 0 ? depth_vertex_array_o : vertex_array_o; }
+    [[nodiscard]] const std::shared_ptr<const Mesh> &GetMesh() const { return mesh; }
+    [[nodiscard]] const Bounds &GetLocalBounds() const { return local_bounds; }
+    [[nodiscard]] const BoundingSphere &GetLocalSphere() const { return local_sphere; }
 
 protected:
+    bool UseInternedMesh(const MeshLibrary::Key &_key); // shares an already built mesh, returns false if there is none yet
+    void InternMesh(const MeshLibrary::Key &_key, int _vertexStride, std::vector<Mesh::Lod> _lods = {}); // moves this object's freshly built geometry into the library
+
+    void SetupGlDepthBuffers(int _vertexStride); // position-only copy of the current vertices & indices, also computes the local bounds
+    void ComputeLocalBounds(int _vertexStride); // box & sphere of the current vertices, for objects without a position-only copy
+
     void SetupGlBuffersVerticesOnly();
     void SetupGlBuffersVerticesAndNormalsOnlyNoIndices();
     void SetupGlBuffersVerticesNormalUv();
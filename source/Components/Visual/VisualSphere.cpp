@@ -1,12 +1,26 @@
 #include "VisualSphere.h"
+#include "Components/GLStateCache.h"
 
 #include <utility>
+#include "glm/common.hpp"
+#include "glm/exponential.hpp"
+#include "glm/geometric.hpp"
 #include "Utility/Transform.hpp"
 
+VisualSphere::LodView VisualSphere::lod_view;
+
 VisualSphere::VisualSphere(float radius, int subdivisions, glm::vec3 _position, glm::vec3 _rotation, glm::vec3 _scale, Shader::Material _material) : VisualObject(_position, _rotation, _scale, std::move(_material))
 {
     VisualSphere::radius = radius;
-    VisualSphere::subdivisions = subdivisions;
+    VisualSphere::subdivisions = glm::clamp(subdivisions, 0, MAX_SUBDIVISIONS);
+
+    lod_levels.assign((size_t)LodPass::ATLAS, VisualSphere::subdivisions);
+
+    // every sphere with the same radius shares the exact same chain of levels, whatever level it starts at
+    const MeshLibrary::Key mesh_key = {MeshLibrary::Shape::SPHERE, {radius}};
+
+    if (UseInternedMesh(mesh_key))
+        return;
 
     // why do we use golden ratio in icosahedron ? 
     // https://en.wikipedia.org/wiki/Regular_icosahedron
@@ -45,47 +59,53 @@ VisualSphere::VisualSphere(float radius, int subdivisions, glm::vec3 _position,
         indices.push_back(indices_arr[i].z);
     }
 
-    // subdivide triangles
-    subdivideTriangles();
+    // every level is appended to the same buffers, each one being the previous level subdivided once more
+    std::vector<float> lod_vertices;
+    std::vector<int> lod_indices;
+    std::vector<Mesh::Lod> lods;
 
-    // calculate normals for vertices
-    std::vector<float> normals; 
-    for (int i = 0; i < vertices.size(); i+=3) {
-        glm::vec3 v = glm::vec3(vertices[i], vertices[i+1], vertices[i+2]);
-        glm::vec3 n = VisualSphere::computeFaceNormals(v);
-        normals.push_back(n.x);
-        normals.push_back(n.y);
-        normals.push_back(n.z);
+    for (int level = 0; level <= MAX_SUBDIVISIONS; level++) {
+        if (level > 0)
+            subdivideTriangles(1);
+
+        appendLod(lod_vertices, lod_indices, lods);
     }
-    // calculate uv for textures for vertices
+
+    vertices = std::move(lod_vertices);
+    indices = std::move(lod_indices);
+
+    VisualObject::SetupGlBuffersVerticesNormalUv();
+    VisualObject::SetupGlDepthBuffers(8);
+    InternMesh(mesh_key, 8, std::move(lods));
+}
+
+void VisualSphere::appendLod(std::vector<float> &_lodVertices, std::vector<int> &_lodIndices, std::vector<Mesh::Lod> &_lods) {
+    _lods.push_back({
+        .index_offset = (GLsizei)_lodIndices.size(),
+        .index_count = (GLsizei)indices.size(),
+        .base_vertex = (GLint)(_lodVertices.size() / 8),
+    });
+
+    _lodIndices.insert(_lodIndices.end(), indices.begin(), indices.end());
+
+    // calculate normals & uv for textures for vertices, interleaved with the positions
     // https://en.wikipedia.org/wiki/UV_mapping
-    std::vector<float> texture; 
     for (int i = 0; i < vertices.size(); i+=3) {
         glm::vec3 v = glm::vec3(vertices[i], vertices[i+1], vertices[i+2]);
+        glm::vec3 n = VisualSphere::computeFaceNormals(v);
         glm::vec2 t = VisualSphere::computeVertexTexture(v);
-        texture.push_back(t.x);
-        texture.push_back(t.y);
-    }
 
-    std::vector<float> temp_v; 
-    for (int i = 0; i < vertices.size(); i+=3) {
-        glm::vec3 v = glm::vec3(vertices[i], vertices[i+1], vertices[i+2]);
-        glm::vec3 n = glm::vec3(normals[i], normals[i+1], normals[i+2]);
-        glm::vec2 t = glm::vec2(texture[i], texture[i+1]);
-        temp_v.push_back(v.x);
-        temp_v.push_back(v.y);
-        temp_v.push_back(v.z);
-
-        temp_v.push_back(n.x);
-        temp_v.push_back(n.y);
-        temp_v.push_back(n.z);
-
-        temp_v.push_back(t.x);
-        temp_v.push_back(t.y);
-    }
+        _lodVertices.push_back(v.x);
+        _lodVertices.push_back(v.y);
+        _lodVertices.push_back(v.z);
 
-    vertices = temp_v;
-    VisualObject::SetupGlBuffersVerticesNormalUv();
+        _lodVertices.push_back(n.x);
+        _lodVertices.push_back(n.y);
+        _lodVertices.push_back(n.z);
+
+        _lodVertices.push_back(t.x);
+        _lodVertices.push_back(t.y);
+    }
 }
 
 glm::vec3 VisualSphere::normalizeVertice(float vx, float vy, float vz) {
@@ -96,9 +116,9 @@ glm::vec3 VisualSphere::normalizeVertice(float vx, float vy, float vz) {
     return glm::vec3(vx, vy, vz);
 }
 
-void VisualSphere::subdivideTriangles() {
+void VisualSphere::subdivideTriangles(int _count) {
     // how many subdivisions to do ?
-    for (int i = 0; i < subdivisions; i++) {
+    for (int i = 0; i < _count; i++) {
         int verticeCount = vertices.size() / 3; // Each vertex has 3 coordinates (x, y, z)
         int indiceCount = indices.size();
         int originalVerticeCount = verticeCount;
@@ -194,20 +214,17 @@ glm::vec2 VisualSphere::computeVertexTexture(glm::vec3 v) {
     return t;
 }
 
-void VisualSphere::Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode, const Shader::Material *material)
+void VisualSphere::Draw(int _renderMode, const Shader::Material *material)
 {
-    glm::mat4 model_matrix = glm::mat4(1.0f);
-    model_matrix = glm::translate(model_matrix, position);
-    model_matrix = Transforms::RotateDegrees(model_matrix, rotation);
-    model_matrix = glm::scale(model_matrix, scale);
-
-    DrawFromMatrix(_viewProjection, _cameraPosition, model_matrix, _renderMode, material);
+    DrawFromMatrix(GetModelMatrix(), _renderMode, material);
 }
 
-void VisualSphere::DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
+void VisualSphere::DrawFromMatrix(const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material *_material)
 {
+    const Mesh::Lod &lod = SelectLod(_transformMatrix);
+
     // bind the vertex array to draw
-    glBindVertexArray(vertex_array_o);
+    GLStateCache::BindVertexArray(vertex_array_o);
 
     const Shader::Material *current_material = &material;
 
@@ -217,33 +234,80 @@ void VisualSphere::DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::v
 
     current_material->shader->Use();
     current_material->shader->SetModelMatrix(_transformMatrix);
-    current_material->shader->SetViewProjectionMatrix(_viewProjection);
 
     current_material->shader->SetVec3("u_color", current_material->color);
     current_material->shader->SetFloat("u_alpha", current_material->alpha);
 
-    current_material->shader->SetVec3("u_cam_pos", _cameraPosition);
+    current_material->shader->SetInt("u_shininess", current_material->shininess);
+    current_material->shader->SetInt("u_receives_shadows", current_material->receives_shadows);
 
-    current_material->shader->SetVec3("u_light_pos", current_material->main_light->GetPosition());
-    current_material->shader->SetVec3("u_light_color", current_material->main_light->GetColor());
+    GLStateCache::BindTexture(1, GL_TEXTURE_2D, current_material->texture);
 
-    current_material->shader->SetFloat("u_ambient_strength", current_material->main_light->ambient_strength);
-    current_material->shader->SetFloat("u_specular_strength", current_material->main_light->specular_strength);
-    current_material->shader->SetInt("u_shininess", current_material->shininess);
+    current_material->shader->SetFloat("u_texture_influence", current_material->texture_influence);
 
-    current_material->shader->SetFloat("u_shadows_influence", 1.0f - (float)current_material->main_light->project_shadows);
-    current_material->shader->SetMat4("u_light_view_projection", current_material->main_light->GetViewProjection());
-    current_material->shader->SetTexture("u_depth_texture", 0);
+    GLStateCache::LineWidth(current_material->line_thickness);
+    GLStateCache::PointSize(current_material->point_size);
 
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, current_material->texture);
+    glDrawElementsBaseVertex(_renderMode, lod.index_count, GL_UNSIGNED_INT, (GLvoid *) (lod.index_offset * sizeof(int)), lod.base_vertex);
 
-    current_material->shader->SetFloat("u_texture_influence", current_material->texture_influence);
-    current_material->shader->SetTexture("u_texture", 1);
+    ++draw_calls;
+}
+
+void VisualSphere::DrawDepth(const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material &_depthMaterial)
+{
+    const Mesh::Lod &lod = SelectLod(_transformMatrix);
+
+    GLStateCache::BindVertexArray(depth_vertex_array_o);
+
+    _depthMaterial.shader->Use();
+    _depthMaterial.shader->SetModelMatrix(_transformMatrix);
+
+    GLStateCache::LineWidth(_depthMaterial.line_thickness);
+    GLStateCache::PointSize(_depthMaterial.point_size);
+
+    glDrawElementsBaseVertex(_renderMode, lod.index_count, GL_UNSIGNED_INT, (GLvoid *) (lod.index_offset * sizeof(int)), lod.base_vertex);
+
+    ++draw_calls;
+}
+
+void VisualSphere::SetLodView(LodPass _pass, const glm::mat4 &_viewProjection, const glm::vec3 &_eyePosition, int _targetHeight, float _bias, int _tile)
+{
+    // the view's vertical scale, at a unit distance (its view matrix only rotates & translates, so it's the projection's own)
+    const float vertical_scale = glm::length(glm::vec3(_viewProjection[0][1], _viewProjection[1][1], _viewProjection[2][1]));
+
+    lod_view = {
+        .slot = (size_t)_pass + (_pass == LodPass::ATLAS ? (size_t)_tile : 0),
+        .eye_position = _eyePosition,
+        .pixels_per_unit = vertical_scale * 0.5f * (float)_targetHeight,
+        // orthographic views don't divide by the distance, so their w row is constant
+        .orthographic = glm::length(glm::vec3(_viewProjection[0][3], _viewProjection[1][3], _viewProjection[2][3])) < 1e-6f,
+        .bias = _bias,
+    };
+}
+
+const Mesh::Lod &VisualSphere::SelectLod(const glm::mat4 &_transformMatrix)
+{
+    if (lod_view.slot >= lod_levels.size())
+        lod_levels.resize(lod_view.slot + 1, subdivisions);
+
+    int &level = lod_levels[lod_view.slot];
+
+    if (lod_view.pixels_per_unit > 0.0f) {
+        const glm::vec3 center = glm::vec3(_transformMatrix[3]);
+        const float scale = glm::max(glm::length(glm::vec3(_transformMatrix[0])), glm::max(glm::length(glm::vec3(_transformMatrix[1])), glm::length(glm::vec3(_transformMatrix[2]))));
+
+        const float distance = lod_view.orthographic ? 1.0f : glm::max(glm::length(center - lod_view.eye_position), 1e-3f);
+        const float pixel_radius = radius * scale * lod_view.pixels_per_unit / distance;
+
+        // an icosahedron's edge spans about 1.1 radians of its sphere, halved by each subdivision
+        const float target_level = glm::log2(glm::max(pixel_radius * 1.1f / LOD_EDGE_PIXELS, 1e-3f)) + lod_view.bias;
+
+        // the level only changes once the target is well past halfway to another one, so that a sphere hovering around that distance doesn't pop back & forth
+        if (glm::abs(target_level - (float)level) > 0.5f + LOD_HYSTERESIS)
+            level = glm::clamp((int)glm::round(target_level), 0, MAX_SUBDIVISIONS);
+    }
 
-    glLineWidth(current_material->line_thickness);
-    glPointSize(current_material->point_size);
+    ++lod_draw_calls[level];
 
-    glDrawElements(_renderMode, indices.size(), GL_UNSIGNED_INT, nullptr);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    return mesh->lods[level];
 }
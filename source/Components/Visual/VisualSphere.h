@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <vector>
 #include "glm/vec3.hpp"
@@ -11,17 +12,55 @@
 class VisualSphere : public VisualObject
 {
 public:
+    // Each view keeps its own level per sphere, so that switching between them never counts as a change of level
+    enum class LodPass : uint8_t {
+        COLOR = 0, // depth prepass included, so that both draw the exact same triangles
+        SHADOW = 1, // the main light's shadow maps
+        ATLAS = 2, // one view per shadow atlas tile
+    };
+
+    // Where spheres are currently drawn from, each draw picking its level of detail from the sphere's projected radius
+    struct LodView {
+    public:
+        size_t slot = 0; // of the view's level in each sphere's lod_levels
+        glm::vec3 eye_position = glm::vec3(0.0f);
+        float pixels_per_unit = 0.0f; // projected size of a world unit, at a unit distance (or anywhere for orthographic views), 0 until a view is set
+        bool orthographic = false;
+        float bias = 0.0f; // in levels, negative for coarser ones
+    };
+
+    inline constexpr static int MAX_SUBDIVISIONS = 6; // finest level of the chain, the coarsest being the icosahedron itself
+    inline constexpr static float LOD_EDGE_PIXELS = 8.0f; // projected length of a triangle's edge each level aims for
+    inline constexpr static float LOD_HYSTERESIS = 0.25f; // how far past halfway to another level (in levels) the target has to go before it's switched to
+
+    static LodView lod_view;
+    inline static std::array<int, MAX_SUBDIVISIONS + 1> lod_draw_calls{}; // per level, since it was last reset (for profiling purposes)
+
     float radius;
-    int subdivisions;
+    int subdivisions; // level drawn until a view picks another
+
+private:
+    std::vector<int> lod_levels; // per view (see LodView::slot), grown as new views draw the sphere
 
+public:
     explicit VisualSphere(float radius = 1.0f, int subdivisions = 1, glm::vec3 _position = glm::vec3(0.0f), glm::vec3 _rotation = glm::vec3(0.0f), glm::vec3 _scale = glm::vec3(1.0f), Shader::Material _material = Shader::Material());
 
-    void subdivideTriangles();
+    void subdivideTriangles(int _count);
 
     glm::vec3 normalizeVertice(float vx, float vy, float vz);
     glm::vec3 computeFaceNormals(glm::vec3 v);
     glm::vec2 computeVertexTexture(glm::vec3 v);
 
-    void Draw(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
-    void DrawFromMatrix(const glm::mat4 &_viewProjection, const glm::vec3 &_cameraPosition, const glm::mat4 &_transformMatrix, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
+    void Draw(int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
+    void DrawFromMatrix(const glm::mat4 &_transformMatrix, int _renderMode = GL_TRIANGLES, const Shader::Material *_material = nullptr) override;
+    void DrawDepth(const glm::mat4 &_transformMatrix, int _renderMode, const Shader::Material &_depthMaterial) override;
+
+    // Every following draw picks its level for this view, e.g. a camera & its viewport's height, or a shadow map & its size
+    // _tile is only used by the atlas pass, whose tiles each have a level of their own
+    static void SetLodView(LodPass _pass, const glm::mat4 &_viewProjection, const glm::vec3 &_eyePosition, int _targetHeight, float _bias, int _tile = 0);
+
+private:
+    void appendLod(std::vector<float> &_lodVertices, std::vector<int> &_lodIndices, std::vector<Mesh::Lod> &_lods); // the current vertices & indices, interleaved with normals & uvs
+
+    const Mesh::Lod &SelectLod(const glm::mat4 &_transformMatrix); // for the current view, with hysteresis
 };
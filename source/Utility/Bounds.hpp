@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/geometric.hpp"
+
+//axis-aligned bounding box, empty (min > max) until something is added to it
+struct Bounds {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+    [[nodiscard]] bool IsEmpty() const {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+
+    [[nodiscard]] glm::vec3 Center() const {
+        return (min + max) * 0.5f;
+    }
+
+    [[nodiscard]] std::array<glm::vec3, 8> Corners() const {
+        std::array<glm::vec3, 8> corners;
+
+        for (int i = 0; i < 8; ++i)
+            corners[i] = glm::vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+
+        return corners;
+    }
+
+    [[nodiscard]] bool Contains(const Bounds &_other) const {
+        return _other.IsEmpty() || (min.x <= _other.min.x && min.y <= _other.min.y && min.z <= _other.min.z &&
+                                    _other.max.x <= max.x && _other.max.y <= max.y && _other.max.z <= max.z);
+    }
+
+    void Add(const glm::vec3 &_point) {
+        min = glm::min(min, _point);
+        max = glm::max(max, _point);
+    }
+
+    void Add(const Bounds &_other) {
+        if (_other.IsEmpty())
+            return;
+
+        Add(_other.min);
+        Add(_other.max);
+    }
+
+    //bounds of this box once transformed (still axis-aligned, so usually a bit larger than the transformed box itself)
+    [[nodiscard]] Bounds Transformed(const glm::mat4 &_transformMatrix) const {
+        Bounds result;
+
+        if (IsEmpty())
+            return result;
+
+        for (const auto &corner : Corners())
+            result.Add(glm::vec3(_transformMatrix * glm::vec4(corner, 1.0f)));
+
+        return result;
+    }
+
+    bool operator==(const Bounds &_other) const {
+        return min == _other.min && max == _other.max;
+    }
+};
+
+//sphere around a set of points, empty (negative radius) until it is given one
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = -1.0f;
+
+    [[nodiscard]] bool IsEmpty() const {
+        return radius < 0.0f;
+    }
+
+    //sphere of the points of a box, as tight as it can be without the points themselves (its corners lie on it)
+    [[nodiscard]] static BoundingSphere Around(const Bounds &_bounds) {
+        if (_bounds.IsEmpty())
+            return {};
+
+        return {.center = _bounds.Center(), .radius = glm::length(_bounds.max - _bounds.min) * 0.5f};
+    }
+
+    //sphere of this sphere once transformed, its radius scaled by the transform's largest axis scale (so that it still holds a non-uniformly scaled object)
+    [[nodiscard]] BoundingSphere Transformed(const glm::mat4 &_transformMatrix) const {
+        if (IsEmpty())
+            return {};
+
+        const float max_scale = glm::max(glm::length(glm::vec3(_transformMatrix[0])), glm::max(glm::length(glm::vec3(_transformMatrix[1])), glm::length(glm::vec3(_transformMatrix[2]))));
+
+        return {.center = glm::vec3(_transformMatrix * glm::vec4(center, 1.0f)), .radius = radius * max_scale};
+    }
+};
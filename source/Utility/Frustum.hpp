@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/geometric.hpp"
+#include "Bounds.hpp"
+
+//the 6 planes of a view projection's clip volume, facing inwards (xyz is the unit normal, w the distance)
+struct Frustum {
+    std::array<glm::vec4, 6> planes;
+
+    Frustum() = default;
+
+    //planes are extracted from the rows of the matrix, a point being inside when -w <= x, y, z <= w in clip space
+    explicit Frustum(const glm::mat4 &_viewProjection) {
+        const glm::vec4 row_x = glm::vec4(_viewProjection[0][0], _viewProjection[1][0], _viewProjection[2][0], _viewProjection[3][0]);
+        const glm::vec4 row_y = glm::vec4(_viewProjection[0][1], _viewProjection[1][1], _viewProjection[2][1], _viewProjection[3][1]);
+        const glm::vec4 row_z = glm::vec4(_viewProjection[0][2], _viewProjection[1][2], _viewProjection[2][2], _viewProjection[3][2]);
+        const glm::vec4 row_w = glm::vec4(_viewProjection[0][3], _viewProjection[1][3], _viewProjection[2][3], _viewProjection[3][3]);
+
+        planes = {row_w + row_x, row_w - row_x, row_w + row_y, row_w - row_y, row_w + row_z, row_w - row_z};
+
+        //normalized, so that a point's distance to a plane is in world units (which spheres need)
+        for (auto &plane : planes)
+            plane /= glm::length(glm::vec3(plane));
+    }
+
+    //conservative: a box is only rejected when it is entirely behind one of the planes (so some boxes near the corners are kept for nothing)
+    [[nodiscard]] bool Intersects(const Bounds &_bounds) const {
+        if (_bounds.IsEmpty())
+            return false;
+
+        for (const auto &plane : planes) {
+            //the box's corner that is the furthest along the plane's normal
+            const glm::vec3 furthest = glm::vec3(plane.x >= 0.0f ? _bounds.max.x : _bounds.min.x,
+                                                 plane.y >= 0.0f ? _bounds.max.y : _bounds.min.y,
+                                                 plane.z >= 0.0f ? _bounds.max.z : _bounds.min.z);
+
+            if (plane.x * furthest.x + plane.y * furthest.y + plane.z * furthest.z + plane.w < 0.0f)
+                return false;
+        }
+
+        return true;
+    }
+
+    //whether a box is entirely in front of every plane, i.e. whether everything it holds is inside too
+    [[nodiscard]] bool Contains(const Bounds &_bounds) const {
+        if (_bounds.IsEmpty())
+            return false;
+
+        for (const auto &plane : planes) {
+            //the box's corner that is the furthest against the plane's normal
+            const glm::vec3 nearest = glm::vec3(plane.x >= 0.0f ? _bounds.min.x : _bounds.max.x,
+                                                plane.y >= 0.0f ? _bounds.min.y : _bounds.max.y,
+                                                plane.z >= 0.0f ? _bounds.min.z : _bounds.max.z);
+
+            if (plane.x * nearest.x + plane.y * nearest.y + plane.z * nearest.z + plane.w < 0.0f)
+                return false;
+        }
+
+        return true;
+    }
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <span>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include "glm/vec3.hpp"
+#include "glm/common.hpp"
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FRUSTUM_CULLER_SSE 1
+#endif
+
+//tests many volumes against frusta at once: the volumes are stored as structure of arrays, so that 4 of them are tested per iteration with SSE
+//each volume is a box (as its center & half extents) and a sphere, it is culled as soon as either of them is entirely behind one of a frustum's planes
+class FrustumCuller {
+public:
+    inline constexpr static size_t LANES = 4;
+
+private:
+    std::vector<float> center_x, center_y, center_z;
+    std::vector<float> extent_x, extent_y, extent_z;
+    std::vector<float> sphere_x, sphere_y, sphere_z, sphere_radius;
+
+    std::vector<uint8_t> visible;
+
+    size_t count = 0;
+
+public:
+    void Clear() {
+        count = 0;
+    }
+
+    //empty volumes are never visible, like with Frustum::Intersects
+    void Add(const Bounds &_bounds, const BoundingSphere &_sphere) {
+        //storage is padded to a whole number of lanes, so that the last iteration doesn't need a scalar tail
+        if (count % LANES == 0)
+            Reserve(count + LANES);
+
+        //a box behind every plane, whatever its center
+        constexpr float empty_extent = std::numeric_limits<float>::lowest() * 0.25f;
+
+        const bool box_empty = _bounds.IsEmpty();
+        const glm::vec3 center = box_empty ? glm::vec3(0.0f) : _bounds.Center();
+        const glm::vec3 extent = box_empty ? glm::vec3(empty_extent) : (_bounds.max - _bounds.min) * 0.5f;
+
+        center_x[count] = center.x;
+        center_y[count] = center.y;
+        center_z[count] = center.z;
+        extent_x[count] = extent.x;
+        extent_y[count] = extent.y;
+        extent_z[count] = extent.z;
+
+        sphere_x[count] = _sphere.center.x;
+        sphere_y[count] = _sphere.center.y;
+        sphere_z[count] = _sphere.center.z;
+        sphere_radius[count] = _sphere.IsEmpty() ? empty_extent : _sphere.radius;
+
+        ++count;
+    }
+
+    //a volume is visible when it is inside any of the frusta
+    void Test(std::span<const Frustum> _frustums) {
+        std::fill(visible.begin(), visible.begin() + (long)GetPaddedCount(), (uint8_t)0);
+
+        for (const auto &frustum : _frustums)
+            TestFrustum(frustum);
+    }
+
+    [[nodiscard]] size_t Size() const { return count; }
+    [[nodiscard]] bool IsVisible(size_t _index) const { return visible[_index] != 0; }
+
+private:
+    [[nodiscard]] size_t GetPaddedCount() const { return (count + LANES - 1) / LANES * LANES; }
+
+    void Reserve(size_t _paddedCount) {
+        if (visible.size() >= _paddedCount)
+            return;
+
+        //the padding lanes are zero-sized volumes at the origin, their results are never read
+        for (auto *lane : {&center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z, &sphere_x, &sphere_y, &sphere_z, &sphere_radius})
+            lane->resize(_paddedCount, 0.0f);
+
+        visible.resize(_paddedCount, 0);
+    }
+
+    void TestFrustum(const Frustum &_frustum) {
+        const size_t padded_count = GetPaddedCount();
+
+#if FRUSTUM_CULLER_SSE
+        const __m128 zero = _mm_setzero_ps();
+
+        for (size_t i = 0; i < padded_count; i += LANES) {
+            const __m128 cx = _mm_loadu_ps(&center_x[i]), cy = _mm_loadu_ps(&center_y[i]), cz = _mm_loadu_ps(&center_z[i]);
+            const __m128 ex = _mm_loadu_ps(&extent_x[i]), ey = _mm_loadu_ps(&extent_y[i]), ez = _mm_loadu_ps(&extent_z[i]);
+            const __m128 sx = _mm_loadu_ps(&sphere_x[i]), sy = _mm_loadu_ps(&sphere_y[i]), sz = _mm_loadu_ps(&sphere_z[i]), sr = _mm_loadu_ps(&sphere_radius[i]);
+
+            __m128 inside = _mm_cmpeq_ps(zero, zero);
+
+            for (const auto &plane : _frustum.planes) {
+                const __m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z), nw = _mm_set1_ps(plane.w);
+                const __m128 abs_nx = _mm_set1_ps(glm::abs(plane.x)), abs_ny = _mm_set1_ps(glm::abs(plane.y)), abs_nz = _mm_set1_ps(glm::abs(plane.z));
+
+                //signed distance of the box's furthest point along the plane's normal (its center's distance, plus its projected half extents)
+                const __m128 center_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), nw));
+                const __m128 box_reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abs_nx, ex), _mm_mul_ps(abs_ny, ey)), _mm_mul_ps(abs_nz, ez));
+
+                const __m128 sphere_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, sx), _mm_mul_ps(ny, sy)), _mm_add_ps(_mm_mul_ps(nz, sz), nw));
+
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(center_distance, box_reach), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(sphere_distance, sr), zero));
+            }
+
+            const int mask = _mm_movemask_ps(inside);
+
+            for (size_t lane = 0; lane < LANES; ++lane)
+                visible[i + lane] |= (uint8_t)((mask >> lane) & 1);
+        }
+#else
+        for (size_t i = 0; i < padded_count; ++i) {
+            bool inside = true;
+
+            for (const auto &plane : _frustum.planes) {
+                const float box_distance = plane.x * center_x[i] + plane.y * center_y[i] + plane.z * center_z[i] + plane.w +
+                                           glm::abs(plane.x) * extent_x[i] + glm::abs(plane.y) * extent_y[i] + glm::abs(plane.z) * extent_z[i];
+                const float sphere_distance = plane.x * sphere_x[i] + plane.y * sphere_y[i] + plane.z * sphere_z[i] + plane.w + sphere_radius[i];
+
+                inside = inside && box_distance >= 0.0f && sphere_distance >= 0.0f;
+            }
+
+            visible[i] |= (uint8_t)inside;
+        }
+#endif
+    }
+};
@@ -3,6 +3,7 @@
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
 #include "Components/Renderer.h"
+#include "Components/GLStateCache.h"
 #include "Utility/Input.hpp"
 
 int main() {
@@ -42,14 +43,17 @@ int main() {
     printf("INFO -> Renderer: %s\n", renderer);
     printf("INFO -> Supported OpenGL version: %s\n", version);
 
+    //nothing is known about the fresh context's state yet
+    GLStateCache::Invalidate();
+
     //enable depth testing and the desired testing function (the closest fragment is drawn)
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+    GLStateCache::SetDepthTest(true);
+    GLStateCache::DepthFunc(GL_LESS);
 
     //enable blending and the desired blending function
     //from: https://learnopengl.com/Advanced-OpenGL/Blending
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLStateCache::SetBlend(true);
+    GLStateCache::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     glfwSetKeyCallback(window, Input::KeyCallback);
     glfwSetErrorCallback([] (int code, const char* desc) {
@@ -71,7 +75,7 @@ int main() {
             previous_display_w = display_w;
             previous_display_h = display_h;
 
-            glViewport(0, 0, display_w, display_h);
+            GLStateCache::Viewport(0, 0, display_w, display_h);
 
             main_renderer.ResizeCallback(window, display_w, display_h);
         }